@@ -8,19 +8,141 @@
 #define IPC_DOMAIN_SOCKET_H_
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <csignal>
+#include <cstdint>
+#include <deque>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+//
+// Buffered reader for one connection. Bytes are read in large blocks into a
+// reusable buffer that is scanned with memchr for the end of each message;
+// anything read past the end is kept for the next message. Messages are
+// handed back as views into the buffer, valid until the next call.
+//
+// On a SOCK_SEQPACKET socket (found on the first Fill) the kernel keeps
+// message boundaries instead: each read takes exactly one packet, whose
+// last byte is the eot, and nothing is scanned.
+//
+// Once switched to frames, messages are instead length-prefixed and may
+// hold any byte, including the eot.
+//
+class MessageReader {
+ public:
+  // Allocated on first use and grown if a message does not fit
+  static const std::size_t kDefaultCapacity = 64 * 1024;
+
+  // Bytes before each frame, holding the length of the message that
+  // follows as a little-endian 32-bit integer
+  static const std::size_t kFrameHeader = 4;
+
+  // Most descriptors accepted with one read; any more are closed by the
+  // kernel
+  static const std::size_t kMaxDescriptors = 8;
+
+  // Room for the control message carrying them
+  static const std::size_t kControlBytes =
+    CMSG_SPACE(kMaxDescriptors * sizeof(int));
+
+  explicit MessageReader(std::size_t capacity = kDefaultCapacity);
+
+  // Blocks for the next message up to the end of transmission character,
+  // which is not part of the message. Returns the bytes consumed, including
+  // the eot character, 0 if the writer disconnected first or < 0 on error.
+  ::ssize_t Read(int socket_fd, char eot, std::string_view* message);
+
+  // As above, for exactly byte_count bytes
+  ::ssize_t Read(int socket_fd, std::size_t byte_count, std::string_view* bytes);
+
+  // Makes one read call into the buffer and returns its result, so a
+  // non-blocking caller can stop on EAGAIN. Descriptors the writer passed
+  // along with the bytes are kept until taken. On a SOCK_SEQPACKET socket
+  // the next packet's size is peeked first, so the buffer only grows as
+  // far as the packets that actually arrive.
+  ::ssize_t Fill(int socket_fd);
+
+  // Fill in two halves, for a caller that makes the recvmsg call itself,
+  // such as through io_uring, on a stream socket. PrepareFill points header
+  // at free space in the buffer (described by *buffer) and at control,
+  // which must hold kControlBytes; all three must stay put until the call
+  // is done.
+  // FinishFill takes the call's result, with errno set if it failed, and
+  // returns it as Fill would.
+  void PrepareFill(int socket_fd,
+                   ::msghdr* header,
+                   ::iovec* buffer,
+                   char control[]);
+  ::ssize_t FinishFill(const ::msghdr& header, ::ssize_t bytes_read);
+
+  // Takes the next complete message from the bytes already read, if any
+  bool Next(char eot, std::string_view* message);
+
+  // Switches between eot-terminated messages and frames, from the next
+  // message on
+  void UseFrames(bool frames) {
+    frames_ = frames;
+  }
+
+  bool Frames() const {
+    return frames_;
+  }
+
+  // Bytes read but not yet returned
+  std::size_t Buffered() const {
+    return end_ - begin_;
+  }
+
+  // Hands over the descriptors received so far, which the caller must close
+  std::vector<int> TakeDescriptors() {
+    std::vector<int> descriptors;
+    descriptors.swap(descriptors_);
+    return descriptors;
+  }
+
+ private:
+  // Makes buffer_ hold at least free_bytes past end_
+  void Reserve(std::size_t free_bytes);
+
+  // Whether socket_fd keeps message boundaries, found on the first call
+  bool Packets(int socket_fd);
+
+  // Next, for a frame
+  bool NextFrame(std::string_view* message);
+
+  // Marks byte_count bytes, and the packets they cover, as returned
+  void Consume(std::size_t byte_count);
+
+  std::vector<char> buffer_;
+  std::vector<int> descriptors_;  // received and not yet taken
+  std::size_t capacity_;
+  std::size_t begin_;    // first byte not yet returned
+  std::size_t end_;      // one past the last byte read
+  std::size_t scanned_;  // bytes from begin_ known not to hold the eot
+
+  int packets_;  // socket keeps boundaries: 1 if so, 0 if not, -1 unknown
+  std::deque<std::size_t> packet_sizes_;  // of packets not yet returned
+  bool frames_;  // messages are frames rather than ended by an eot
+};
+
 
 //
 // Base class for Unix domain sockets (shared functionality for both clients and servers)
 //
 class UnixDomainSocket {
  public:
-  explicit UnixDomainSocket(const char* socket_path, bool abstract = true);
+  // type is SOCK_STREAM, or SOCK_SEQPACKET to have the kernel keep each
+  // message's boundaries; both ends must use the same
+  explicit UnixDomainSocket(const char* socket_path,
+                            bool abstract = true,
+                            int type = SOCK_STREAM);
 
   virtual ~UnixDomainSocket();
 
@@ -37,27 +159,71 @@ class UnixDomainSocket {
   // Begins construction of Unix domain socket, server or client should finish
   bool Init();
 
-  // Read until end of transmission character and store in buffer
+  // Read until end of transmission character; message views reader's
+  // buffer, which must be the same for every read from the descriptor
   ::ssize_t Read(int socket_file_descriptor,
                  char end_of_transmission,
-                 std::string* buffer) const;
+                 MessageReader* reader,
+                 std::string_view* message) const;
 
-  // Read set number of bytes and store in buffer
+  // Read set number of bytes through reader
   ::ssize_t Read(int socket_file_descriptor,
                  std::size_t return_after_bytes,
-                 std::string* buffer) const;
+                 MessageReader* reader,
+                 std::string_view* bytes) const;
 
-  // Write message and then send end of transmission character
+  // Write message and then send end of transmission character, together in
+  // one gather write, retried until everything is sent
   ::ssize_t Write(int socket_file_descriptor,
                   const std::string& message,
                   char eot) const;
 
+  // Write each message followed by the end of transmission character, all
+  // in as few system calls as the kernel allows; on a SOCK_SEQPACKET socket
+  // each is its own packet
+  ::ssize_t Write(int socket_file_descriptor,
+                  const std::vector<std::string>& messages,
+                  char eot) const;
+
+  // As the first Write, passing copies of descriptors to the reader with
+  // the message (SCM_RIGHTS)
+  ::ssize_t Write(int socket_file_descriptor,
+                  const std::string& message,
+                  char eot,
+                  const std::vector<int>& descriptors) const;
+
+  // Write each message as a frame, preceded by its length rather than
+  // followed by an eot; on a SOCK_SEQPACKET socket each is its own packet
+  ::ssize_t WriteFrames(int socket_file_descriptor,
+                        const std::vector<std::string>& messages) const;
+
+  // Appends message to out as a frame
+  static void AppendFrame(std::string_view message, std::string* out);
+
+  // Sends count packets, each gathered from the next per_packet buffers, in
+  // as few sendmmsg calls as possible. Returns the number of packets sent
+  // (fewer if a non-blocking socket fills) or -1 if none could be.
+  ::ssize_t WritePackets(int socket_file_descriptor,
+                         ::iovec buffers[],
+                         std::size_t per_packet,
+                         std::size_t count) const;
+
   int socket_fd_;        // server or client's socket file descriptor
+  int socket_type_;      // SOCK_STREAM or SOCK_SEQPACKET
   std::string socket_path_;  // name of socket
   ::sockaddr_un sock_addr_;  // Unix socket address structure
 
  private:
-  ::ssize_t Read(int socket_fd, char buffer[], std::size_t buffer_size) const;
+  // Reports a read that ended the message early
+  ::ssize_t Report(::ssize_t bytes_read) const;
+
+  // Writes every byte the count buffers describe, continuing after short
+  // writes. The buffers are advanced past what was written.
+  ::ssize_t WriteAll(int socket_fd, ::iovec buffers[], std::size_t count) const;
+
+  // Writes messages described by two buffers apiece, as one stream or as a
+  // packet apiece, depending on the socket
+  ::ssize_t WriteMessages(int socket_fd, std::vector<::iovec>* buffers) const;
 };
 
 
@@ -67,8 +233,9 @@ class UnixDomainSocket {
 class DomainSocketServer : public UnixDomainSocket {
  public:
   explicit DomainSocketServer(const char* socket_path,
-                              char us, char eot, bool abstract = true)
-      : UnixDomainSocket(socket_path, abstract), us_(us), eot_(eot) {
+                              char us, char eot, bool abstract = true,
+                              int type = SOCK_STREAM)
+      : UnixDomainSocket(socket_path, abstract, type), us_(us), eot_(eot) {
     // empty
   }
 
@@ -79,15 +246,121 @@ class DomainSocketServer : public UnixDomainSocket {
   // is a blocking call.
   int Accept();  
 
-  // pass the file descriptor from Accept to read a client's message
+  // pass the file descriptor from Accept to read a client's message. Any
+  // bytes the client sent after it are discarded.
   ::ssize_t Read(int socket_file_descriptor, std::string* message) const;
 
+  // As above, keeping bytes past the message in the connection's reader
+  ::ssize_t Read(int socket_file_descriptor,
+                 MessageReader* reader,
+                 std::string_view* message) const;
+
   // pass the first descriptor from Accept to write message to a client
   ::ssize_t Write(int socket_file_descriptor, const std::string& message) const;
 
+  // As above for several messages at once, e.g., queued replies
+  ::ssize_t Write(int socket_file_descriptor,
+                  const std::vector<std::string>& messages) const;
+
+  // Event-driven alternative to calling Accept, Read and Write in turn. Call
+  // after Init. Every client is multiplexed on the calling thread with epoll
+  // and non-blocking sockets, so a slow client never holds up the others.
+  // Each connection is sent Greeting(), then every message it sends (up to
+  // eot_) is passed to RespondTo and answered in order until the client
+  // disconnects. Clients may send requests without waiting for replies.
+  // Returns once *keep_running becomes zero, or false if epoll fails.
+  bool Serve(const volatile ::sig_atomic_t* keep_running);
+
+  // As Serve, with io_uring in place of epoll. One multishot accept takes
+  // every new client, and each round's reads and writes for all clients
+  // are submitted together with one system call, which also collects the
+  // completions. Replies are sent straight from each connection's output
+  // with IORING_OP_SEND. Serves with epoll instead if the kernel lacks
+  // io_uring or the socket is SOCK_SEQPACKET.
+  bool ServeUring(const volatile ::sig_atomic_t* keep_running);
+
  protected:
+  // Sent to each client as it connects; eot_ is appended
+  virtual std::string Greeting() {
+    return std::string();
+  }
+
+  // Builds the reply to a client's message (without its eot_); eot_ is
+  // appended
+  virtual std::string Respond(std::string_view message) {
+    return std::string(message);
+  }
+
+  // As Respond, for a message from the given client; override this instead
+  // to keep state per connection
+  virtual std::string RespondTo(int client_fd, std::string_view message) {
+    (void)client_fd;
+    return Respond(message);
+  }
+
+  // Called with descriptors a client passed, before the messages that came
+  // with them are answered. The receiver owns them; by default they are
+  // closed.
+  virtual void Received(int client_fd, const std::vector<int>& descriptors) {
+    (void)client_fd;
+    for (int descriptor : descriptors)
+      ::close(descriptor);
+  }
+
+  // Called as Serve closes a client's connection, before its descriptor
+  // can be reused
+  virtual void Disconnected(int client_fd) {
+    (void)client_fd;
+  }
+
+  // Asked after each message a client sends: whether its later messages,
+  // and the replies to them, are frames rather than ended by eot_
+  virtual bool UsesFrames(int client_fd) {
+    (void)client_fd;
+    return false;
+  }
+
   char us_;
   char eot_;
+
+ private:
+  // Per-client state for Serve. Every complete request read is answered
+  // at once; more input is read only after all output has been sent, so a
+  // client that does not read its replies cannot grow output forever.
+  struct Connection {
+    MessageReader input;
+    std::string output;   // greeting and replies not yet sent
+    std::size_t written;  // bytes of output already sent
+    bool closing;         // client is done sending; close once output is sent
+    std::uint32_t events;  // what epoll is watching for
+    std::vector<std::size_t> ends;  // message ends in output, for packets
+  };
+
+  // ServeUring's ring and clients, defined with it
+  class UringLoop;
+
+  // Accepts every pending client
+  void AcceptAll(int epoll_fd);
+
+  // Answers every complete message a connection has read, queueing the
+  // replies in its output
+  void AnswerAll(int client_fd, Connection* connection);
+
+  // Sends as many of a SOCK_SEQPACKET connection's pending replies as fit,
+  // one packet apiece. Returns the bytes sent, as write would.
+  ::ssize_t WriteReplies(int client_fd, Connection* connection) const;
+
+  // Advances a connection as far as it can go without blocking. Returns
+  // false once the connection is finished or failed and should be closed.
+  bool Advance(int epoll_fd, int client_fd, Connection* connection);
+
+  // Changes what epoll watches a connection for, if it differs
+  bool Watch(int epoll_fd,
+             int client_fd,
+             Connection* connection,
+             std::uint32_t events) const;
+
+  std::unordered_map<int, Connection> connections_;  // by client descriptor
 };
 
 
@@ -107,8 +380,31 @@ class DomainSocketClient : public UnixDomainSocket {
   // Read until end of transmission character and store in buffer
   ::ssize_t Read(char eot, std::string* buffer) const;
 
+  // As above without copying; message is valid until the next Read
+  ::ssize_t Read(char eot, std::string_view* message) const;
+
   // Write message and send end of transmission character
   ::ssize_t Write(const std::string& message, char eot) const;
+
+  // Write several messages, each followed by eot, in one batch
+  ::ssize_t Write(const std::vector<std::string>& messages, char eot) const;
+
+  // Write message and eot, passing descriptors to the server with them
+  ::ssize_t Write(const std::string& message,
+                  char eot,
+                  const std::vector<int>& descriptors) const;
+
+  // Write several messages as frames in one batch
+  ::ssize_t WriteFrames(const std::vector<std::string>& messages) const;
+
+  // Reads frames rather than eot-terminated messages from now on, or the
+  // reverse; the eot passed to Read is then ignored
+  void UseFrames(bool frames) const {
+    reader_.UseFrames(frames);
+  }
+
+ private:
+  mutable MessageReader reader_;  // keeps bytes read past a message
 };
 
 #endif  // IPC_DOMAIN_SOCKET_H_
@@ -0,0 +1,136 @@
+// Copyright 2025 CSCE 311
+//
+// This file defines SharedMemoryChannel, a transport that carries messages
+// between two processes through shared memory rather than a socket. Once
+// both ends hold the channel's descriptors (passed over a domain socket,
+// see DomainSocketClient::Write), messages move with no system calls while
+// both sides keep up with each other.
+//
+#ifndef IPC_SHARED_MEMORY_CHANNEL_H_
+#define IPC_SHARED_MEMORY_CHANNEL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//
+// Two single-producer single-consumer rings in one memfd, one each way, and
+// two eventfds per ring, one for its reader to sleep on and one for its
+// writer. Each message is a 32-bit length followed by its bytes, and may
+// wrap around the end of the ring. A side that finds its ring empty (or
+// full) spins briefly, then flags that it is waiting and sleeps on its
+// eventfd; the other side writes that eventfd only when it sees the flag,
+// so a busy channel never enters the kernel.
+//
+// The client end Creates the channel and passes Descriptors() to the
+// server, which Attaches to them. The memfd is sealed at its size, so
+// neither end can truncate it under the other's mapping. Send and Receive
+// on one end must each be called from one thread at a time; Close may be
+// called from any thread.
+//
+class SharedMemoryChannel {
+ public:
+  // Bytes in each ring; a message and its length must fit in one
+  static const std::size_t kDefaultCapacity = 1 << 20;
+
+  // The memfd, then the reader's and the writer's eventfds of the
+  // client-to-server ring, then those of the server-to-client ring
+  static const std::size_t kDescriptors = 5;
+
+  SharedMemoryChannel();
+
+  // Unmaps the rings and closes the descriptors
+  ~SharedMemoryChannel();
+
+  // Creates the shared memory and eventfds, as the client end. capacity is
+  // rounded up to a power of two.
+  bool Create(std::size_t capacity = kDefaultCapacity);
+
+  // Maps a channel from the descriptors its creator passed, as the server
+  // end, refusing a memfd not sealed against shrinking, growing and further
+  // changes to its seals. Takes ownership of the descriptors whether or not
+  // it succeeds.
+  bool Attach(const std::vector<int>& descriptors);
+
+  // The descriptors to pass to the other end
+  std::vector<int> Descriptors() const;
+
+  // Queues message for the other end, waiting up to timeout_milliseconds
+  // (-1 for no limit) while the ring is full. Returns false if the channel
+  // is closed, the message cannot fit, or no room came in time. An end that
+  // cannot trust the other to keep reading should give a limit.
+  bool Send(std::string_view message, int timeout_milliseconds = -1);
+
+  // Waits up to timeout_milliseconds (-1 for no limit) for the next message
+  // from the other end. Returns 1 with a message, 0 if none came in time,
+  // or -1 once the channel is closed and drained. A ring whose positions or
+  // lengths do not add up (the other end can write anything into it) closes
+  // the channel and returns -1.
+  int Receive(std::string* message, int timeout_milliseconds);
+
+  // Tells both ends that no more messages will be sent, waking either if
+  // it is waiting
+  void Close();
+
+ private:
+  // Shared by both ends at the front of each ring's part of the memfd. The
+  // positions only grow; each is written by one side alone.
+  struct Ring {
+    alignas(64) std::atomic<std::uint64_t> head;  // bytes ever written
+    alignas(64) std::atomic<std::uint64_t> tail;  // bytes ever read
+    alignas(64) std::atomic<std::uint32_t> reader_waiting;
+    std::atomic<std::uint32_t> writer_waiting;
+    std::atomic<std::uint32_t> closed;
+    std::uint64_t capacity;
+  };
+
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+                "shared rings need lock-free atomics");
+
+  // Maps the memfd and finds both rings; client tells which one is ours
+  // to write
+  bool Map(bool client);
+
+  // Spins, then sleeps on event_fd with *waiting set, until ready() holds
+  // or timeout_milliseconds (-1 for no limit) pass. Returns ready().
+  template <typename Ready>
+  bool Wait(Ready ready,
+            std::atomic<std::uint32_t>* waiting,
+            int event_fd,
+            int timeout_milliseconds) const;
+
+  // Wakes the other side if it flagged that it is waiting
+  static void Signal(const std::atomic<std::uint32_t>& waiting, int event_fd);
+
+  // Copy between a ring's data and a flat buffer, wrapping at the end
+  void CopyIn(Ring* ring, std::uint64_t position,
+              const void* bytes, std::size_t size) const;
+  void CopyOut(const Ring* ring, std::uint64_t position,
+               void* bytes, std::size_t size) const;
+
+  void Release();
+
+  int memory_fd_;
+  int event_fds_[kDescriptors - 1];  // in Descriptors() order
+  void* mapping_;
+  std::size_t mapping_size_;
+
+  Ring* out_;  // the ring this end writes
+  Ring* in_;   // the ring this end reads
+  int out_reader_fd_;  // wakes the other end for a message
+  int out_writer_fd_;  // sleeps on for room in out_
+  int in_reader_fd_;   // sleeps on for a message in in_
+  int in_writer_fd_;   // wakes the other end for room
+  std::size_t capacity_;  // of each ring, as checked when mapped; the
+                          // shared copies are never read again
+  std::size_t spins_;  // polls of the ring before sleeping
+
+  // Non-copyable
+  SharedMemoryChannel(const SharedMemoryChannel&) = delete;
+  SharedMemoryChannel& operator=(const SharedMemoryChannel&) = delete;
+};
+
+#endif  // IPC_SHARED_MEMORY_CHANNEL_H_
@@ -0,0 +1,77 @@
+// Copyright 2025 CSCE 311
+//
+// This file defines Uring, a small wrapper around a Linux io_uring instance
+// made with raw system calls (no liburing). Operations are queued in a ring
+// shared with the kernel and handed over together, and their completions
+// are read back from a second ring, so many reads, writes and accepts cost
+// one io_uring_enter between them.
+//
+#ifndef IPC_URING_H_
+#define IPC_URING_H_
+
+#include <linux/io_uring.h>
+
+#include <cstddef>
+
+//
+// One io_uring: a submission ring of io_uring_sqe entries and a completion
+// ring of io_uring_cqe entries, both mapped from the kernel. Prepare hands
+// out a cleared entry to fill in, Submit passes every prepared entry to the
+// kernel (and may wait for completions), and Complete takes completions
+// off their ring. Meant for one thread.
+//
+class Uring {
+ public:
+  Uring();
+
+  // Unmaps the rings and closes the instance, which cancels whatever is
+  // still in flight
+  ~Uring();
+
+  // Sets up the rings for entries submissions at a time. Returns false,
+  // with errno set, if the kernel has no io_uring, forbids it, or lacks a
+  // feature used here (both rings in one mapping and timed waits, Linux
+  // 5.11 and later).
+  bool Init(unsigned entries);
+
+  // A cleared submission entry to fill in, sent with the next Submit, or
+  // nullptr if every entry is already prepared
+  ::io_uring_sqe* Prepare();
+
+  // Passes every prepared entry to the kernel and, if wait is set, waits
+  // up to timeout_milliseconds for at least one completion. Returns false
+  // on an error other than a signal or the wait running out.
+  bool Submit(bool wait, int timeout_milliseconds);
+
+  // Takes up to count completions off their ring; returns how many
+  std::size_t Complete(::io_uring_cqe completions[], std::size_t count);
+
+ private:
+  void Release();
+
+  int ring_fd_;
+  void* rings_;  // both rings' indexes and the completion entries
+  std::size_t rings_size_;
+  ::io_uring_sqe* entries_;
+  std::size_t entries_size_;
+
+  // Submission ring; the kernel advances head, this side the tail
+  unsigned* sq_head_;
+  unsigned* sq_tail_;
+  unsigned* sq_array_;
+  unsigned sq_mask_;
+  unsigned sq_entries_;
+  unsigned prepared_tail_;  // tail including entries not yet submitted
+
+  // Completion ring; the kernel advances tail, this side the head
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  ::io_uring_cqe* completions_;
+  unsigned cq_mask_;
+
+  // Non-copyable
+  Uring(const Uring&) = delete;
+  Uring& operator=(const Uring&) = delete;
+};
+
+#endif  // IPC_URING_H_
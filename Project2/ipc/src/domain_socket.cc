@@ -2,11 +2,237 @@
 //
 
 #include <domain_socket.h>
+#include <uring.h>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+
+#include <cerrno>
+#include <climits>  // IOV_MAX
 #include <cstring>
 
+namespace {
+
+// Frame headers are little-endian whatever the host's byte order
+void EncodeLength(std::uint32_t length, char header[]) {
+  for (std::size_t i = 0; i < MessageReader::kFrameHeader; ++i)
+    header[i] = static_cast<char>(length >> (8 * i));
+}
+
+std::uint32_t DecodeLength(const char header[]) {
+  std::uint32_t length = 0;
+  for (std::size_t i = 0; i < MessageReader::kFrameHeader; ++i)
+    length |= std::uint32_t(static_cast<unsigned char>(header[i])) << (8 * i);
+  return length;
+}
+
+}  // namespace
+
+//
+// MessageReader methods
+//
+MessageReader::MessageReader(std::size_t capacity)
+    : capacity_(std::max<std::size_t>(capacity, 1)),
+      begin_(0), end_(0), scanned_(0), packets_(-1), frames_(false) {
+  // empty
+}
+
+::ssize_t MessageReader::Read(int socket_fd,
+                              char eot,
+                              std::string_view* message) {
+  while (!Next(eot, message)) {
+    ::ssize_t bytes_read = Fill(socket_fd);
+    if (bytes_read <= 0)
+      return bytes_read;
+  }
+
+  return message->size() + (frames_ ? kFrameHeader : 1);
+}
+
+::ssize_t MessageReader::Read(int socket_fd,
+                              std::size_t byte_count,
+                              std::string_view* bytes) {
+  while (Buffered() < byte_count) {
+    ::ssize_t bytes_read = Fill(socket_fd);
+    if (bytes_read <= 0)
+      return bytes_read;
+  }
+
+  *bytes = std::string_view(buffer_.data() + begin_, byte_count);
+  Consume(byte_count);
+  return byte_count;
+}
+
+::ssize_t MessageReader::Fill(int socket_fd) {
+  // A packet must arrive whole, so make room for all of the next one
+  // before reading it; MSG_TRUNC has the peek return its full size
+  if (Packets(socket_fd)) {
+    ::ssize_t size = ::recv(socket_fd, nullptr, 0, MSG_PEEK | MSG_TRUNC);
+    if (size < 0)
+      return size;
+    Reserve(std::max<std::size_t>(size, 1));
+  }
+
+  ::msghdr header;
+  ::iovec buffer;
+  alignas(::cmsghdr) char control[kControlBytes];
+  PrepareFill(socket_fd, &header, &buffer, control);
+
+  ::ssize_t bytes_read = ::recvmsg(socket_fd, &header, MSG_CMSG_CLOEXEC);
+  if (bytes_read < 0 && errno == ENOTSOCK)
+    bytes_read = ::read(socket_fd, buffer.iov_base, buffer.iov_len);
+
+  return FinishFill(header, bytes_read);
+}
+
+void MessageReader::PrepareFill(int socket_fd,
+                                ::msghdr* header,
+                                ::iovec* buffer,
+                                char control[]) {
+  Packets(socket_fd);
+  Reserve(1);
+
+  // recvmsg rather than read, so descriptors the writer passed are kept
+  // instead of being dropped
+  *buffer = {buffer_.data() + end_, buffer_.size() - end_};
+  *header = {};
+  header->msg_iov = buffer;
+  header->msg_iovlen = 1;
+  header->msg_control = control;
+  header->msg_controllen = kControlBytes;
+}
+
+::ssize_t MessageReader::FinishFill(const ::msghdr& header,
+                                    ::ssize_t bytes_read) {
+  if (bytes_read > 0 && packets_ && (header.msg_flags & MSG_TRUNC)) {
+    errno = EMSGSIZE;  // the rest of the packet is gone
+    bytes_read = -1;
+  }
+  if (bytes_read > 0) {
+    end_ += bytes_read;
+    if (packets_)
+      packet_sizes_.push_back(bytes_read);
+  }
+
+  if (bytes_read >= 0) {
+    for (::cmsghdr* message = CMSG_FIRSTHDR(&header);
+         message != nullptr;
+         message = CMSG_NXTHDR(const_cast<::msghdr*>(&header), message)) {
+      if (message->cmsg_level != SOL_SOCKET || message->cmsg_type != SCM_RIGHTS)
+        continue;
+
+      std::size_t count = (message->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      const unsigned char* data = CMSG_DATA(message);
+      for (std::size_t i = 0; i < count; ++i) {
+        int descriptor;
+        std::memcpy(&descriptor, data + i * sizeof(int), sizeof(int));
+        descriptors_.push_back(descriptor);
+      }
+    }
+  }
+
+  return bytes_read;
+}
+
+bool MessageReader::Next(char eot, std::string_view* message) {
+  if (frames_)
+    return NextFrame(message);
+
+  if (packets_ > 0) {
+    if (packet_sizes_.empty())
+      return false;
+
+    // The writer ends every packet with the eot, which is dropped
+    std::size_t length = packet_sizes_.front();
+    packet_sizes_.pop_front();
+    const char* begin = buffer_.data() + begin_;
+    begin_ += length;
+    if (begin[length - 1] == eot)
+      --length;
+    *message = std::string_view(begin, length);
+    return true;
+  }
+
+  if (begin_ == end_)
+    return false;
+
+  const char* begin = buffer_.data() + begin_;
+  const void* found = std::memchr(begin + scanned_,
+                                  eot,
+                                  end_ - begin_ - scanned_);
+  if (!found) {
+    scanned_ = end_ - begin_;
+    return false;
+  }
+
+  std::size_t length = static_cast<const char*>(found) - begin;
+  *message = std::string_view(begin, length);
+  begin_ += length + 1;
+  scanned_ = 0;
+  return true;
+}
+
+bool MessageReader::NextFrame(std::string_view* message) {
+  if (Buffered() < kFrameHeader)
+    return false;
+
+  std::size_t length = DecodeLength(buffer_.data() + begin_);
+  if (Buffered() - kFrameHeader < length)
+    return false;
+
+  *message = std::string_view(buffer_.data() + begin_ + kFrameHeader, length);
+  Consume(kFrameHeader + length);
+  return true;
+}
+
+void MessageReader::Consume(std::size_t byte_count) {
+  begin_ += byte_count;
+  scanned_ = 0;
+
+  // Packets the bytes covered are used up, the last perhaps only in part
+  while (byte_count > 0 && !packet_sizes_.empty()) {
+    std::size_t taken = std::min(byte_count, packet_sizes_.front());
+    byte_count -= taken;
+    packet_sizes_.front() -= taken;
+    if (packet_sizes_.front() == 0)
+      packet_sizes_.pop_front();
+  }
+}
+
+bool MessageReader::Packets(int socket_fd) {
+  if (packets_ < 0) {
+    // Anything but a socket (or a failed query) is read as a stream
+    int type = 0;
+    ::socklen_t length = sizeof(type);
+    packets_ = ::getsockopt(socket_fd, SOL_SOCKET, SO_TYPE, &type, &length) == 0
+               && type == SOCK_SEQPACKET;
+  }
+  return packets_ > 0;
+}
+
+void MessageReader::Reserve(std::size_t free_bytes) {
+  if (begin_ == end_) {
+    begin_ = end_ = 0;  // nothing pending, so start over at the front
+  } else if (buffer_.size() - end_ < free_bytes && begin_ > 0) {
+    // Slide the pending bytes to the front to make room
+    std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+    end_ -= begin_;
+    begin_ = 0;
+  }
+
+  std::size_t size = buffer_.empty() ? capacity_ : buffer_.size();
+  while (size - end_ < free_bytes)
+    size *= 2;
+  if (size != buffer_.size())
+    buffer_.resize(size);
+}
+
+
 // DomainSocket constructor
-UnixDomainSocket::UnixDomainSocket(const char* socket_path, bool abstract)
-    : socket_fd_(0), socket_path_(socket_path) {
+UnixDomainSocket::UnixDomainSocket(const char* socket_path,
+                                   bool abstract,
+                                   int type)
+    : socket_fd_(0), socket_type_(type), socket_path_(socket_path) {
   sock_addr_ = {};  // equivalent to memset(0)
   sock_addr_.sun_family = AF_UNIX;
   if (abstract) {
@@ -24,7 +250,7 @@ UnixDomainSocket::~UnixDomainSocket() {
 
 bool UnixDomainSocket::Init() {
   // (1) create a socket
-  socket_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  socket_fd_ = ::socket(AF_UNIX, socket_type_, 0);
 
   if (socket_fd_ < 1)
       std::cerr << "Socket Creation Error: " << ::strerror(errno) << std::endl;
@@ -38,97 +264,236 @@ void UnixDomainSocket::Close(int socket_fd) const {
 
 ::ssize_t UnixDomainSocket::Read(int socket_fd,
                                  char eot,
-                                 std::string* output) const {
-  const size_t kBufferSize = 64;
-  char buffer[kBufferSize];
+                                 MessageReader* reader,
+                                 std::string_view* message) const {
+  return Report(reader->Read(socket_fd, eot, message));
+}
 
-  ::ssize_t bytes_read = Read(socket_fd, buffer, kBufferSize);
-  if (bytes_read <= 0)
-      return bytes_read;
+::ssize_t UnixDomainSocket::Read(int socket_fd,
+                                 std::size_t byte_count,
+                                 MessageReader* reader,
+                                 std::string_view* bytes) const {
+  return Report(reader->Read(socket_fd, byte_count, bytes));
+}
 
-  ::ssize_t total_bytes_read = bytes_read;
+::ssize_t UnixDomainSocket::Report(::ssize_t bytes_read) const {
+  if (bytes_read == 0) {
+      std::cout << "Writer disconnected" << std::endl;
+  } else if (bytes_read < 0) {
+      std::cerr << "Read Error: " << ::strerror(errno) << std::endl;
+  }
 
-  while (buffer[bytes_read - 1] != eot) {
-      output->insert(output->size(), buffer, bytes_read);
+  return bytes_read;
+}
 
-      bytes_read = Read(socket_fd, buffer, kBufferSize);
-      if (bytes_read <= 0)
-          return total_bytes_read;
-      total_bytes_read += bytes_read;
-  }
 
-  // If we are reading to EOT, omit the final EOT char
-  output->insert(output->size(), buffer, bytes_read - 1);
+::ssize_t UnixDomainSocket::Write(int socket_fd,
+                                  const std::string& bytes,
+                                  char eot) const {
+  // Payload and eot char leave in the same system call, so the reader sees
+  // them arrive together
+  ::iovec buffers[2];
+  buffers[0].iov_base = const_cast<char*>(bytes.data());
+  buffers[0].iov_len = bytes.size();
+  buffers[1].iov_base = &eot;
+  buffers[1].iov_len = 1;
 
-  return total_bytes_read;
+  return WriteAll(socket_fd, buffers, 2);
 }
 
-::ssize_t UnixDomainSocket::Read(int socket_fd,
-                                 std::size_t byte_count,
-                                 std::string* output) const {
-  const size_t kBufferSize = 64;
-  char buffer[kBufferSize];
-
-  ::ssize_t bytes_read = Read(socket_fd,
-                              buffer,
-                              std::min(kBufferSize, byte_count));
-  if (bytes_read <= 0)
-      return bytes_read;
 
-  ::ssize_t total_bytes_read = bytes_read;
+::ssize_t UnixDomainSocket::Write(int socket_fd,
+                                  const std::vector<std::string>& messages,
+                                  char eot) const {
+  std::vector<::iovec> buffers(2 * messages.size());
+  for (std::size_t i = 0; i < messages.size(); ++i) {
+    buffers[2 * i].iov_base = const_cast<char*>(messages[i].data());
+    buffers[2 * i].iov_len = messages[i].size();
+    buffers[2 * i + 1].iov_base = &eot;
+    buffers[2 * i + 1].iov_len = 1;
+  }
 
-  while (static_cast<std::size_t>(bytes_read) < byte_count) {
-      output->append(buffer, bytes_read);
+  return WriteMessages(socket_fd, &buffers);
+}
 
-      bytes_read = Read(socket_fd,
-                        buffer,
-                        std::min(byte_count - total_bytes_read, kBufferSize));
-      if (bytes_read <= 0)
-          return total_bytes_read;
-      total_bytes_read += bytes_read;
+
+::ssize_t UnixDomainSocket::WriteFrames(
+    int socket_fd,
+    const std::vector<std::string>& messages) const {
+  std::vector<char> headers(MessageReader::kFrameHeader * messages.size());
+  std::vector<::iovec> buffers(2 * messages.size());
+  for (std::size_t i = 0; i < messages.size(); ++i) {
+    char* header = headers.data() + MessageReader::kFrameHeader * i;
+    EncodeLength(messages[i].size(), header);
+    buffers[2 * i].iov_base = header;
+    buffers[2 * i].iov_len = MessageReader::kFrameHeader;
+    buffers[2 * i + 1].iov_base = const_cast<char*>(messages[i].data());
+    buffers[2 * i + 1].iov_len = messages[i].size();
   }
 
-  // If we are reading to EOT, omit the final EOT char
-  output->insert(output->size(), buffer, byte_count ? bytes_read : bytes_read - 1);
+  return WriteMessages(socket_fd, &buffers);
+}
 
-  return total_bytes_read;
+
+void UnixDomainSocket::AppendFrame(std::string_view message,
+                                   std::string* out) {
+  char header[MessageReader::kFrameHeader];
+  EncodeLength(message.size(), header);
+  out->append(header, sizeof(header));
+  out->append(message);
 }
 
-::ssize_t UnixDomainSocket::Read(int socket_fd,
-                                 char buffer[],
-                                 std::size_t buffer_size) const {
-  ::ssize_t bytes_read = ::read(socket_fd, buffer, buffer_size);
 
-  if (bytes_read == 0) {
-      std::cout << "Writer disconnected" << std::endl;
-  } else if (bytes_read < 0) {
-      std::cerr << "Read Error: " << ::strerror(errno) << std::endl;
+::ssize_t UnixDomainSocket::WriteMessages(
+    int socket_fd,
+    std::vector<::iovec>* buffers) const {
+  if (socket_type_ != SOCK_SEQPACKET)
+    return WriteAll(socket_fd, buffers->data(), buffers->size());
+
+  // One writev would make one packet of everything, so each message is
+  // sent as a packet of its own
+  std::size_t messages = buffers->size() / 2;
+  ::ssize_t total_written = 0;
+  for (std::size_t sent = 0; sent < messages; ) {
+    ::iovec* next = buffers->data() + 2 * sent;
+    ::ssize_t packets = WritePackets(socket_fd, next, 2, messages - sent);
+    if (packets < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EPIPE)
+        std::cerr << strerror(errno) << std::endl;
+      return -1;
+    }
+
+    for (::ssize_t i = 0; i < 2 * packets; ++i)
+      total_written += next[i].iov_len;
+    sent += packets;
   }
 
-  return bytes_read;
+  return total_written;
 }
 
 
 ::ssize_t UnixDomainSocket::Write(int socket_fd,
                                   const std::string& bytes,
-                                  char eot) const {
-  ::ssize_t bytes_written = ::write(socket_fd, bytes.c_str(), bytes.size());
-  if (bytes_written < 0 && errno == EPIPE) {
-    // NOTE you may recieve SIGPIPE, which, if ignored, terminates
-    // your app. Typically, you do not register a signal handler for
-    // SIGPIPE, you just ignore:
-    //   signal(SIGPIPE, SIG_IGN);
-    // server dropped connection with client still writing
-    std::cerr << strerror(errno) << std::endl;
+                                  char eot,
+                                  const std::vector<int>& descriptors) const {
+  ::iovec buffers[2];
+  buffers[0].iov_base = const_cast<char*>(bytes.data());
+  buffers[0].iov_len = bytes.size();
+  buffers[1].iov_base = &eot;
+  buffers[1].iov_len = 1;
+
+  // The descriptors travel with the first byte sent; any bytes a short
+  // write leaves behind follow as usual
+  std::vector<char> control(CMSG_SPACE(descriptors.size() * sizeof(int)));
+  ::msghdr header = {};
+  header.msg_iov = buffers;
+  header.msg_iovlen = 2;
+  header.msg_control = control.data();
+  header.msg_controllen = control.size();
+
+  ::cmsghdr* message = CMSG_FIRSTHDR(&header);
+  message->cmsg_level = SOL_SOCKET;
+  message->cmsg_type = SCM_RIGHTS;
+  message->cmsg_len = CMSG_LEN(descriptors.size() * sizeof(int));
+  std::memcpy(CMSG_DATA(message),
+              descriptors.data(),
+              descriptors.size() * sizeof(int));
+
+  ::ssize_t bytes_written = ::sendmsg(socket_fd, &header, 0);
+  if (bytes_written < 0) {
+    std::cerr << "Write Error: " << ::strerror(errno) << std::endl;
+    return -1;
+  }
+
+  std::size_t remaining = bytes_written;
+  ::iovec* rest = buffers;
+  std::size_t count = 2;
+  while (count > 0 && remaining >= rest->iov_len) {
+    remaining -= rest->iov_len;
+    ++rest;
+    --count;
+  }
+  if (count == 0)
     return bytes_written;
+
+  rest->iov_base = static_cast<char*>(rest->iov_base) + remaining;
+  rest->iov_len -= remaining;
+  ::ssize_t rest_written = WriteAll(socket_fd, rest, count);
+  return rest_written < 0 ? -1 : bytes_written + rest_written;
+}
+
+
+::ssize_t UnixDomainSocket::WriteAll(int socket_fd,
+                                     ::iovec buffers[],
+                                     std::size_t count) const {
+  // The kernel takes at most IOV_MAX buffers per call
+  const std::size_t kMaxBuffers = IOV_MAX;
+
+  ::ssize_t total_written = 0;
+  while (count > 0) {
+    ::ssize_t bytes_written = ::writev(socket_fd,
+                                       buffers,
+                                       std::min(count, kMaxBuffers));
+    if (bytes_written < 0) {
+      // NOTE you may recieve SIGPIPE, which, if ignored, terminates
+      // your app. Typically, you do not register a signal handler for
+      // SIGPIPE, you just ignore:
+      //   signal(SIGPIPE, SIG_IGN);
+      // server dropped connection with client still writing
+      if (errno == EPIPE)
+        std::cerr << strerror(errno) << std::endl;
+      return -1;
+    }
+    total_written += bytes_written;
+
+    // Skip whatever was sent, which may end partway through a buffer
+    std::size_t remaining = bytes_written;
+    while (count > 0 && remaining >= buffers->iov_len) {
+      remaining -= buffers->iov_len;
+      ++buffers;
+      --count;
+    }
+    if (count > 0) {
+      buffers->iov_base = static_cast<char*>(buffers->iov_base) + remaining;
+      buffers->iov_len -= remaining;
+    }
   }
 
-  if (::write(socket_fd, &eot, 1) < 0 && errno == EPIPE) {  // send eot char
-    std::cerr << strerror(errno) << std::endl;
-    return -1;
+  return total_written;
+}
+
+
+::ssize_t UnixDomainSocket::WritePackets(int socket_fd,
+                                         ::iovec buffers[],
+                                         std::size_t per_packet,
+                                         std::size_t count) const {
+  // The kernel takes at most UIO_MAXIOV packets per call
+  const std::size_t kMaxPackets = 1024;
+
+  std::vector<::mmsghdr> headers(std::min(count, kMaxPackets));
+  ::ssize_t total_sent = 0;
+  while (count > 0) {
+    std::size_t batch = std::min(count, kMaxPackets);
+    for (std::size_t i = 0; i < batch; ++i) {
+      headers[i] = {};
+      headers[i].msg_hdr.msg_iov = buffers + i * per_packet;
+      headers[i].msg_hdr.msg_iovlen = per_packet;
+    }
+
+    int sent = ::sendmmsg(socket_fd, headers.data(), batch, MSG_NOSIGNAL);
+    if (sent < 0)
+      return total_sent > 0 ? total_sent : -1;
+
+    total_sent += sent;
+    buffers += sent * per_packet;
+    count -= sent;
+    if (static_cast<std::size_t>(sent) < batch)
+      break;  // the socket is full
   }
 
-  return bytes_written + 1;
+  return total_sent;
 }
 
 
@@ -174,7 +539,20 @@ int DomainSocketServer::Accept() {
 
 
 ::ssize_t DomainSocketServer::Read(int socket_fd, std::string* buffer) const {
-  return UnixDomainSocket::Read(socket_fd, eot_, buffer);
+  MessageReader reader;
+  std::string_view message;
+  ::ssize_t bytes_read = Read(socket_fd, &reader, &message);
+  if (bytes_read > 0)
+    buffer->append(message);
+
+  return bytes_read;
+}
+
+
+::ssize_t DomainSocketServer::Read(int socket_fd,
+                                   MessageReader* reader,
+                                   std::string_view* message) const {
+  return UnixDomainSocket::Read(socket_fd, eot_, reader, message);
 }
 
 
@@ -184,6 +562,575 @@ int DomainSocketServer::Accept() {
 }
 
 
+::ssize_t DomainSocketServer::Write(
+    int socket_fd,
+    const std::vector<std::string>& messages) const {
+  return UnixDomainSocket::Write(socket_fd, messages, eot_);
+}
+
+
+bool DomainSocketServer::Serve(const volatile ::sig_atomic_t* keep_running) {
+  int epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd < 0) {
+    std::cerr << "DomainSocketServer::Serve Error: " << ::strerror(errno)
+      << std::endl;
+    return false;
+  }
+
+  // The listening socket must not block once accept has drained it
+  int flags = ::fcntl(socket_fd_, F_GETFL, 0);
+  ::epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = socket_fd_;
+  if (flags < 0
+      || ::fcntl(socket_fd_, F_SETFL, flags | O_NONBLOCK) < 0
+      || ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket_fd_, &event) < 0) {
+    std::cerr << "DomainSocketServer::Serve Error: " << ::strerror(errno)
+      << std::endl;
+    ::close(epoll_fd);
+    return false;
+  }
+
+  // Wake up now and then so a signal that arrives just before epoll_wait
+  // still stops the loop promptly
+  const int kWaitMilliseconds = 500;
+  const int kMaxEvents = 64;
+  ::epoll_event events[kMaxEvents];
+
+  bool success = true;
+  while (*keep_running) {
+    int ready = ::epoll_wait(epoll_fd, events, kMaxEvents, kWaitMilliseconds);
+    if (ready < 0) {
+      if (errno == EINTR)
+        continue;
+      std::cerr << "DomainSocketServer::Serve Error: " << ::strerror(errno)
+        << std::endl;
+      success = false;
+      break;
+    }
+
+    for (int i = 0; i < ready; ++i) {
+      int fd = events[i].data.fd;
+      if (fd == socket_fd_) {
+        AcceptAll(epoll_fd);
+        continue;
+      }
+
+      auto connection = connections_.find(fd);
+      if (connection != connections_.end()
+          && !Advance(epoll_fd, fd, &connection->second)) {
+        Disconnected(fd);
+        Close(fd);  // also removes it from the epoll set
+        connections_.erase(connection);
+      }
+    }
+  }
+
+  for (const auto& connection : connections_) {
+    Disconnected(connection.first);
+    Close(connection.first);
+  }
+  connections_.clear();
+  ::close(epoll_fd);
+
+  return success;
+}
+
+
+void DomainSocketServer::AcceptAll(int epoll_fd) {
+  for (;;) {
+    int client_fd = ::accept4(socket_fd_, nullptr, nullptr, SOCK_NONBLOCK);
+    if (client_fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+        std::cerr << "DomainSocketServer::Accept Error: " << strerror(errno)
+          << std::endl;
+      return;
+    }
+
+    Connection& connection = connections_[client_fd];
+    connection.input = MessageReader();
+    connection.output = Greeting();
+    connection.output.push_back(eot_);
+    connection.ends.clear();
+    if (socket_type_ == SOCK_SEQPACKET)
+      connection.ends.push_back(connection.output.size());
+    connection.written = 0;
+    connection.closing = false;
+    connection.events = EPOLLIN;
+
+    ::epoll_event event = {};
+    event.events = connection.events;
+    event.data.fd = client_fd;
+    if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client_fd, &event) < 0
+        || !Advance(epoll_fd, client_fd, &connection)) {
+      Disconnected(client_fd);
+      Close(client_fd);
+      connections_.erase(client_fd);
+    }
+  }
+}
+
+
+bool DomainSocketServer::Advance(int epoll_fd,
+                                 int client_fd,
+                                 Connection* connection) {
+  for (;;) {
+    // Answer every complete request read so far; replies to requests that
+    // arrived together leave together
+    AnswerAll(client_fd, connection);
+
+    if (connection->written < connection->output.size()) {
+      ::ssize_t bytes_written = socket_type_ == SOCK_SEQPACKET
+                                ? WriteReplies(client_fd, connection)
+                                : ::write(client_fd,
+                                          connection->output.data()
+                                            + connection->written,
+                                          connection->output.size()
+                                            - connection->written);
+      if (bytes_written < 0 && errno == EINTR)
+        continue;
+      if (bytes_written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return Watch(epoll_fd, client_fd, connection, EPOLLOUT);
+      if (bytes_written < 0)
+        return false;
+
+      connection->written += bytes_written;
+      if (connection->written == connection->output.size()) {
+        connection->output.clear();
+        connection->ends.clear();
+        connection->written = 0;
+      }
+      continue;
+    }
+
+    if (connection->closing)
+      return false;  // every request has been answered
+
+    ::ssize_t bytes_read = connection->input.Fill(client_fd);
+    std::vector<int> descriptors = connection->input.TakeDescriptors();
+    if (!descriptors.empty())
+      Received(client_fd, descriptors);
+    if (bytes_read < 0 && errno == EINTR)
+      continue;
+    if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return Watch(epoll_fd, client_fd, connection, EPOLLIN);
+    if (bytes_read < 0)
+      return false;
+    if (bytes_read == 0)
+      connection->closing = true;  // drop any unfinished message
+  }
+}
+
+
+void DomainSocketServer::AnswerAll(int client_fd, Connection* connection) {
+  std::string_view message;
+  while (connection->input.Next(eot_, &message)) {
+    // A reply is framed as its request was, even if that request switched
+    // framing
+    bool frames = connection->input.Frames();
+    std::string reply = RespondTo(client_fd, message);
+    connection->input.UseFrames(UsesFrames(client_fd));
+    if (frames) {
+      AppendFrame(reply, &connection->output);
+    } else {
+      connection->output += reply;
+      connection->output.push_back(eot_);
+    }
+    if (socket_type_ == SOCK_SEQPACKET)
+      connection->ends.push_back(connection->output.size());
+  }
+}
+
+
+::ssize_t DomainSocketServer::WriteReplies(int client_fd,
+                                          Connection* connection) const {
+  // Only whole packets are ever sent, so written is always a message end
+  auto next = std::upper_bound(connection->ends.begin(),
+                               connection->ends.end(),
+                               connection->written);
+  std::vector<::iovec> buffers;
+  buffers.reserve(connection->ends.end() - next);
+  std::size_t begin = connection->written;
+  for (auto end = next; end != connection->ends.end(); ++end) {
+    buffers.push_back({connection->output.data() + begin, *end - begin});
+    begin = *end;
+  }
+
+  ::ssize_t packets = WritePackets(client_fd, buffers.data(), 1, buffers.size());
+  if (packets <= 0)
+    return packets;
+  return next[packets - 1] - connection->written;
+}
+
+
+bool DomainSocketServer::Watch(int epoll_fd,
+                               int client_fd,
+                               Connection* connection,
+                               std::uint32_t events) const {
+  if (connection->events == events)
+    return true;
+
+  ::epoll_event event = {};
+  event.events = events;
+  event.data.fd = client_fd;
+  if (::epoll_ctl(epoll_fd, EPOLL_CTL_MOD, client_fd, &event) < 0)
+    return false;
+
+  connection->events = events;
+  return true;
+}
+
+
+//
+// io_uring server loop
+//
+class DomainSocketServer::UringLoop {
+ public:
+  explicit UringLoop(DomainSocketServer* server) : server_(server) {}
+
+  // Sets up the ring; false, with errno set, if io_uring is unusable
+  bool Init();
+
+  // Serves clients until *keep_running becomes zero; false if the ring
+  // fails
+  bool Run(const volatile ::sig_atomic_t* keep_running);
+
+ private:
+  // Submission entries per round; a round that needs more submits early
+  static const unsigned kEntries = 256;
+
+  // What a completion is for, kept in the low byte of its user_data with
+  // the descriptor above it
+  enum Operation : std::uint64_t { kAccept, kRead, kWrite, kCancel };
+
+  // A connection and the read or write the kernel holds for it, at most
+  // one at a time; the kernel fills header and control as the read ends
+  struct Client : Connection {
+    ::msghdr header;
+    ::iovec buffer;
+    alignas(::cmsghdr) char control[MessageReader::kControlBytes];
+    std::uint64_t pending;  // user_data of the operation in flight, or 0
+  };
+
+  static std::uint64_t Tag(Operation operation, int fd) {
+    return static_cast<std::uint64_t>(fd) << 8 | operation;
+  }
+
+  // A submission entry, submitting those already prepared if the ring is
+  // full; nullptr if even that fails
+  ::io_uring_sqe* Prepare();
+
+  // Queues an accept for every client to come, or just the next one on
+  // kernels before 5.19
+  void Accept();
+
+  // Handles a completion of any kind
+  void Completed(const ::io_uring_cqe& completion);
+  void Accepted(const ::io_uring_cqe& completion);
+
+  // Answers what a client has sent and queues its next write or read.
+  // Returns false once it is finished or failed and should be closed.
+  bool Advance(int client_fd, Client* client);
+  bool QueueRead(int client_fd, Client* client);
+  bool QueueWrite(int client_fd, Client* client);
+
+  // Closes a client with nothing in flight
+  void Close(int client_fd);
+
+  // Cancels everything in flight and waits for it to end, so the kernel is
+  // done with every client's buffers before they are freed
+  void Drain();
+  void Cancel(std::uint64_t user_data);
+
+  DomainSocketServer* server_;
+  Uring ring_;
+  std::unordered_map<int, Client> clients_;
+  bool multishot_ = true;   // kernel takes multishot accepts
+  bool accepting_ = false;  // an accept is queued or in flight
+  bool draining_ = false;
+  std::size_t in_flight_ = 0;  // reads and writes
+};
+
+
+bool DomainSocketServer::UringLoop::Init() {
+  return ring_.Init(kEntries);
+}
+
+
+bool DomainSocketServer::UringLoop::Run(
+    const volatile ::sig_atomic_t* keep_running) {
+  // Wake up now and then so a signal that arrives just before the wait
+  // still stops the loop promptly
+  const int kWaitMilliseconds = 500;
+  const std::size_t kMaxCompletions = 64;
+  ::io_uring_cqe completions[kMaxCompletions];
+
+  bool success = true;
+  while (*keep_running) {
+    if (!accepting_)
+      Accept();
+
+    // Everything queued while handling the last completions goes to the
+    // kernel in this one call
+    if (!ring_.Submit(true, kWaitMilliseconds)) {
+      std::cerr << "DomainSocketServer::ServeUring Error: "
+        << ::strerror(errno) << std::endl;
+      success = false;
+      break;
+    }
+
+    std::size_t count;
+    while ((count = ring_.Complete(completions, kMaxCompletions)) > 0) {
+      for (std::size_t i = 0; i < count; ++i)
+        Completed(completions[i]);
+    }
+  }
+
+  Drain();
+  while (!clients_.empty())
+    Close(clients_.begin()->first);
+
+  return success;
+}
+
+
+::io_uring_sqe* DomainSocketServer::UringLoop::Prepare() {
+  ::io_uring_sqe* entry = ring_.Prepare();
+  if (entry == nullptr && ring_.Submit(false, 0))
+    entry = ring_.Prepare();
+  return entry;
+}
+
+
+void DomainSocketServer::UringLoop::Accept() {
+  ::io_uring_sqe* entry = Prepare();
+  if (entry == nullptr)
+    return;  // try again next round
+
+  entry->opcode = IORING_OP_ACCEPT;
+  entry->fd = server_->socket_fd_;
+  entry->accept_flags = SOCK_CLOEXEC;
+  if (multishot_)
+    entry->ioprio = IORING_ACCEPT_MULTISHOT;
+  entry->user_data = Tag(kAccept, server_->socket_fd_);
+  accepting_ = true;
+}
+
+
+void DomainSocketServer::UringLoop::Completed(
+    const ::io_uring_cqe& completion) {
+  int fd = static_cast<int>(completion.user_data >> 8);
+  Operation operation = static_cast<Operation>(completion.user_data & 0xff);
+  if (operation == kAccept) {
+    Accepted(completion);
+    return;
+  }
+
+  auto found = clients_.find(fd);
+  if (operation == kCancel
+      || found == clients_.end()
+      || found->second.pending != completion.user_data)
+    return;
+
+  Client& client = found->second;
+  client.pending = 0;
+  --in_flight_;
+  if (draining_)
+    return;
+
+  bool failed;
+  if (operation == kRead) {
+    ::ssize_t bytes_read = completion.res;
+    if (bytes_read < 0) {
+      errno = -completion.res;
+      bytes_read = -1;
+    }
+    bytes_read = client.input.FinishFill(client.header, bytes_read);
+
+    std::vector<int> descriptors = client.input.TakeDescriptors();
+    if (!descriptors.empty())
+      server_->Received(fd, descriptors);
+    if (bytes_read == 0)
+      client.closing = true;  // drop any unfinished message
+    failed = bytes_read < 0 && errno != EINTR && errno != EAGAIN;
+  } else {
+    if (completion.res > 0) {
+      client.written += completion.res;
+      if (client.written == client.output.size()) {
+        client.output.clear();
+        client.ends.clear();
+        client.written = 0;
+      }
+    }
+    failed = completion.res <= 0
+             && completion.res != -EINTR && completion.res != -EAGAIN;
+  }
+
+  if (failed || !Advance(fd, &client))
+    Close(fd);
+}
+
+
+void DomainSocketServer::UringLoop::Accepted(
+    const ::io_uring_cqe& completion) {
+  // A multishot accept goes on until it reports otherwise
+  if (!(completion.flags & IORING_CQE_F_MORE))
+    accepting_ = false;
+
+  if (completion.res < 0) {
+    if (completion.res == -EINVAL && multishot_) {
+      multishot_ = false;  // kernel predates multishot accepts
+    } else if (completion.res != -ECANCELED
+               && completion.res != -EINTR
+               && completion.res != -ECONNABORTED) {
+      std::cerr << "DomainSocketServer::Accept Error: "
+        << ::strerror(-completion.res) << std::endl;
+    }
+    return;
+  }
+
+  int client_fd = completion.res;
+  if (draining_) {
+    ::close(client_fd);
+    return;
+  }
+
+  Client& client = clients_[client_fd];
+  client.input = MessageReader();
+  client.output = server_->Greeting();
+  client.output.push_back(server_->eot_);
+  client.ends.clear();
+  client.written = 0;
+  client.closing = false;
+  client.pending = 0;
+
+  if (!Advance(client_fd, &client))
+    Close(client_fd);
+}
+
+
+bool DomainSocketServer::UringLoop::Advance(int client_fd, Client* client) {
+  server_->AnswerAll(client_fd, client);
+
+  if (client->written < client->output.size())
+    return QueueWrite(client_fd, client);
+
+  if (client->closing)
+    return false;  // every request has been answered
+
+  return QueueRead(client_fd, client);
+}
+
+
+bool DomainSocketServer::UringLoop::QueueRead(int client_fd, Client* client) {
+  ::io_uring_sqe* entry = Prepare();
+  if (entry == nullptr)
+    return false;
+
+  client->input.PrepareFill(client_fd,
+                            &client->header,
+                            &client->buffer,
+                            client->control);
+  entry->opcode = IORING_OP_RECVMSG;
+  entry->fd = client_fd;
+  entry->addr = reinterpret_cast<std::uintptr_t>(&client->header);
+  entry->len = 1;
+  entry->msg_flags = MSG_CMSG_CLOEXEC;
+  entry->user_data = client->pending = Tag(kRead, client_fd);
+  ++in_flight_;
+  return true;
+}
+
+
+bool DomainSocketServer::UringLoop::QueueWrite(int client_fd, Client* client) {
+  ::io_uring_sqe* entry = Prepare();
+  if (entry == nullptr)
+    return false;
+
+  // output stays untouched until the send completes, so the kernel copies
+  // the replies straight out of it
+  entry->opcode = IORING_OP_SEND;
+  entry->fd = client_fd;
+  entry->addr = reinterpret_cast<std::uintptr_t>(client->output.data()
+                                                 + client->written);
+  entry->len = client->output.size() - client->written;
+  entry->msg_flags = MSG_NOSIGNAL;
+  entry->user_data = client->pending = Tag(kWrite, client_fd);
+  ++in_flight_;
+  return true;
+}
+
+
+void DomainSocketServer::UringLoop::Close(int client_fd) {
+  auto found = clients_.find(client_fd);
+  server_->Disconnected(client_fd);
+  server_->Close(client_fd);
+  clients_.erase(found);
+}
+
+
+void DomainSocketServer::UringLoop::Drain() {
+  draining_ = true;
+  for (const auto& client : clients_) {
+    if (client.second.pending != 0)
+      Cancel(client.second.pending);
+  }
+  if (accepting_)
+    Cancel(Tag(kAccept, server_->socket_fd_));
+
+  // Cancelled operations end promptly; give up after a few seconds rather
+  // than hang on a kernel that does not
+  const int kWaitMilliseconds = 100;
+  const int kMaxWaits = 50;
+  const std::size_t kMaxCompletions = 64;
+  ::io_uring_cqe completions[kMaxCompletions];
+  for (int wait = 0; wait < kMaxWaits && (in_flight_ > 0 || accepting_); ++wait) {
+    if (!ring_.Submit(true, kWaitMilliseconds))
+      break;
+
+    std::size_t count;
+    while ((count = ring_.Complete(completions, kMaxCompletions)) > 0) {
+      for (std::size_t i = 0; i < count; ++i)
+        Completed(completions[i]);
+    }
+  }
+}
+
+
+void DomainSocketServer::UringLoop::Cancel(std::uint64_t user_data) {
+  ::io_uring_sqe* entry = Prepare();
+  if (entry == nullptr)
+    return;
+
+  entry->opcode = IORING_OP_ASYNC_CANCEL;
+  entry->addr = user_data;
+  entry->user_data = Tag(kCancel, 0);
+}
+
+
+bool DomainSocketServer::ServeUring(
+    const volatile ::sig_atomic_t* keep_running) {
+  // A write of several replies would be one packet, so packets keep to
+  // epoll, which sends each on its own
+  if (socket_type_ == SOCK_SEQPACKET) {
+    std::cerr << "DomainSocketServer::ServeUring: serving packets with epoll"
+      << std::endl;
+    return Serve(keep_running);
+  }
+
+  UringLoop loop(this);
+  if (!loop.Init()) {
+    std::cerr << "DomainSocketServer::ServeUring: io_uring unavailable ("
+      << ::strerror(errno) << "), serving with epoll" << std::endl;
+    return Serve(keep_running);
+  }
+
+  return loop.Run(keep_running);
+}
+
+
 //
 // Client methods
 //
@@ -201,14 +1148,46 @@ bool DomainSocketClient::Init() {
 }
 
 ::ssize_t DomainSocketClient::Read(std::size_t return_after_bytes, std::string* buffer) const {
-  return UnixDomainSocket::Read(socket_fd_, return_after_bytes, buffer);
+  std::string_view bytes;
+  ::ssize_t bytes_read = UnixDomainSocket::Read(socket_fd_,
+                                                return_after_bytes,
+                                                &reader_,
+                                                &bytes);
+  if (bytes_read > 0)
+    buffer->append(bytes);
+
+  return bytes_read;
 }
 
 ::ssize_t DomainSocketClient::Read(char eot, std::string* buffer) const {
-  return UnixDomainSocket::Read(socket_fd_, eot, buffer);
+  std::string_view message;
+  ::ssize_t bytes_read = Read(eot, &message);
+  if (bytes_read > 0)
+    buffer->append(message);
+
+  return bytes_read;
+}
+
+::ssize_t DomainSocketClient::Read(char eot, std::string_view* message) const {
+  return UnixDomainSocket::Read(socket_fd_, eot, &reader_, message);
 }
 
 ::ssize_t DomainSocketClient::Write(const std::string& bytes, char eot) const {
   return UnixDomainSocket::Write(socket_fd_, bytes, eot);
 }
 
+::ssize_t DomainSocketClient::Write(const std::vector<std::string>& messages,
+                                    char eot) const {
+  return UnixDomainSocket::Write(socket_fd_, messages, eot);
+}
+
+::ssize_t DomainSocketClient::Write(const std::string& bytes,
+                                    char eot,
+                                    const std::vector<int>& descriptors) const {
+  return UnixDomainSocket::Write(socket_fd_, bytes, eot, descriptors);
+}
+
+::ssize_t DomainSocketClient::WriteFrames(
+    const std::vector<std::string>& messages) const {
+  return UnixDomainSocket::WriteFrames(socket_fd_, messages);
+}
@@ -0,0 +1,340 @@
+// Copyright 2025 CSCE 311
+//
+
+#include <shared_memory_channel.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <thread>
+
+namespace {
+
+// Ring polls before sleeping, when the other side can run at the same time
+const std::size_t kSpins = 2000;
+
+// Keep the memfd the size both ends mapped, so neither can make the other
+// fault by truncating it
+const int kSeals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+
+}  // namespace
+
+
+SharedMemoryChannel::SharedMemoryChannel()
+    : memory_fd_(-1), mapping_(nullptr), mapping_size_(0),
+      out_(nullptr), in_(nullptr), out_reader_fd_(-1), out_writer_fd_(-1),
+      in_reader_fd_(-1), in_writer_fd_(-1), capacity_(0),
+      spins_(std::thread::hardware_concurrency() > 1 ? kSpins : 0) {
+  for (int& fd : event_fds_)
+    fd = -1;
+}
+
+
+SharedMemoryChannel::~SharedMemoryChannel() {
+  Release();
+}
+
+
+void SharedMemoryChannel::Release() {
+  if (mapping_)
+    ::munmap(mapping_, mapping_size_);
+  mapping_ = nullptr;
+  out_ = in_ = nullptr;
+
+  if (memory_fd_ >= 0)
+    ::close(memory_fd_);
+  memory_fd_ = -1;
+  for (int& fd : event_fds_) {
+    if (fd >= 0)
+      ::close(fd);
+    fd = -1;
+  }
+  out_reader_fd_ = out_writer_fd_ = in_reader_fd_ = in_writer_fd_ = -1;
+  capacity_ = 0;
+}
+
+
+bool SharedMemoryChannel::Create(std::size_t capacity) {
+  Release();
+
+  std::size_t rounded = 64;
+  while (rounded < capacity)
+    rounded *= 2;
+  mapping_size_ = 2 * (sizeof(Ring) + rounded);
+
+  memory_fd_ = ::memfd_create("bool-expr-channel",
+                              MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  bool created = memory_fd_ >= 0;
+  for (int& fd : event_fds_) {
+    fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    created = created && fd >= 0;
+  }
+  if (!created || ::ftruncate(memory_fd_, mapping_size_) < 0
+      || ::fcntl(memory_fd_, F_ADD_SEALS, kSeals) < 0) {
+    std::cerr << "SharedMemoryChannel Error: " << ::strerror(errno)
+      << std::endl;
+    Release();
+    return false;
+  }
+
+  if (!Map(true)) {
+    Release();
+    return false;
+  }
+
+  // The memfd starts zeroed, which is every field's initial value but one
+  out_->capacity = in_->capacity = rounded;
+  capacity_ = rounded;
+  return true;
+}
+
+
+bool SharedMemoryChannel::Attach(const std::vector<int>& descriptors) {
+  Release();
+  if (descriptors.size() != kDescriptors) {
+    for (int fd : descriptors)
+      ::close(fd);
+    return false;
+  }
+
+  memory_fd_ = descriptors[0];
+  std::copy(descriptors.begin() + 1, descriptors.end(), event_fds_);
+
+  // A memfd its creator could still resize is refused
+  struct stat sb;
+  int seals = ::fcntl(memory_fd_, F_GET_SEALS);
+  if (seals < 0 || (seals & kSeals) != kSeals) {
+    std::cerr << "SharedMemoryChannel Error: channel is not sealed"
+      << std::endl;
+    Release();
+    return false;
+  }
+  if (::fstat(memory_fd_, &sb) < 0
+      || static_cast<std::size_t>(sb.st_size) < 2 * sizeof(Ring)) {
+    Release();
+    return false;
+  }
+  mapping_size_ = sb.st_size;
+
+  if (!Map(false)) {
+    Release();
+    return false;
+  }
+
+  // Both rings must be the size the creator gave the memfd
+  std::uint64_t capacity = in_->capacity;
+  bool valid = capacity >= 64 && (capacity & (capacity - 1)) == 0
+               && out_->capacity == capacity
+               && mapping_size_ == 2 * (sizeof(Ring) + capacity);
+  if (!valid) {
+    std::cerr << "SharedMemoryChannel Error: malformed channel" << std::endl;
+    Release();
+    return false;
+  }
+
+  capacity_ = capacity;
+  return true;
+}
+
+
+bool SharedMemoryChannel::Map(bool client) {
+  mapping_ = ::mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    memory_fd_, 0);
+  if (mapping_ == MAP_FAILED) {
+    std::cerr << "SharedMemoryChannel Error: " << ::strerror(errno)
+      << std::endl;
+    mapping_ = nullptr;
+    return false;
+  }
+
+  // The client-to-server ring comes first, then the server-to-client one
+  char* bytes = static_cast<char*>(mapping_);
+  Ring* to_server = reinterpret_cast<Ring*>(bytes);
+  Ring* to_client = reinterpret_cast<Ring*>(bytes + mapping_size_ / 2);
+  out_ = client ? to_server : to_client;
+  in_ = client ? to_client : to_server;
+  const int* to_server_fds = event_fds_;
+  const int* to_client_fds = event_fds_ + 2;
+  const int* out_fds = client ? to_server_fds : to_client_fds;
+  const int* in_fds = client ? to_client_fds : to_server_fds;
+  out_reader_fd_ = out_fds[0];
+  out_writer_fd_ = out_fds[1];
+  in_reader_fd_ = in_fds[0];
+  in_writer_fd_ = in_fds[1];
+  return true;
+}
+
+
+std::vector<int> SharedMemoryChannel::Descriptors() const {
+  std::vector<int> descriptors = {memory_fd_};
+  descriptors.insert(descriptors.end(), std::begin(event_fds_),
+                     std::end(event_fds_));
+  return descriptors;
+}
+
+
+bool SharedMemoryChannel::Send(std::string_view message,
+                               int timeout_milliseconds) {
+  const std::size_t size = sizeof(std::uint32_t) + message.size();
+  if (!out_ || size > capacity_)
+    return false;
+
+  const std::uint64_t head = out_->head.load(std::memory_order_relaxed);
+  auto room = [&]() {
+    return out_->closed.load()
+           || capacity_ - (head - out_->tail.load(std::memory_order_acquire))
+              >= size;
+  };
+  if (!Wait(room, &out_->writer_waiting, out_writer_fd_, timeout_milliseconds)
+      || out_->closed.load())
+    return false;
+
+  std::uint32_t length = message.size();
+  CopyIn(out_, head, &length, sizeof(length));
+  CopyIn(out_, head + sizeof(length), message.data(), message.size());
+  out_->head.store(head + size, std::memory_order_release);
+
+  Signal(out_->reader_waiting, out_reader_fd_);
+  return true;
+}
+
+
+int SharedMemoryChannel::Receive(std::string* message,
+                                 int timeout_milliseconds) {
+  if (!in_)
+    return -1;
+
+  const std::uint64_t tail = in_->tail.load(std::memory_order_relaxed);
+  auto pending = [&]() {
+    return in_->head.load(std::memory_order_acquire) != tail
+           || in_->closed.load();
+  };
+  if (!Wait(pending, &in_->reader_waiting, in_reader_fd_, timeout_milliseconds))
+    return 0;
+  const std::uint64_t head = in_->head.load(std::memory_order_acquire);
+  if (head == tail)
+    return -1;  // closed, and every message has been read
+
+  // The writer owns head and the bytes, so check them before trusting
+  // either: what it claims to have written must fit the ring, and the
+  // message must lie within it
+  std::uint32_t length = 0;
+  const std::uint64_t available = head - tail;
+  if (available >= sizeof(length) && available <= capacity_)
+    CopyOut(in_, tail, &length, sizeof(length));
+  if (available < sizeof(length) || available > capacity_
+      || length > available - sizeof(length)) {
+    std::cerr << "SharedMemoryChannel Error: malformed message" << std::endl;
+    Close();
+    return -1;
+  }
+
+  message->resize(length);
+  CopyOut(in_, tail + sizeof(length), message->data(), length);
+  in_->tail.store(tail + sizeof(length) + length, std::memory_order_release);
+
+  Signal(in_->writer_waiting, in_writer_fd_);
+  return 1;
+}
+
+
+void SharedMemoryChannel::Close() {
+  if (!out_)
+    return;
+
+  out_->closed.store(1);
+  in_->closed.store(1);
+
+  // Wake every sleeper on both rings unconditionally
+  const std::uint64_t kOne = 1;
+  for (int fd : event_fds_)
+    if (::write(fd, &kOne, sizeof(kOne)) < 0) {
+      // already signalled as far as it can be
+    }
+}
+
+
+template <typename Ready>
+bool SharedMemoryChannel::Wait(Ready ready,
+                               std::atomic<std::uint32_t>* waiting,
+                               int event_fd,
+                               int timeout_milliseconds) const {
+  for (std::size_t spin = 0; spin < spins_; ++spin)
+    if (ready())
+      return true;
+
+  // Flag the wait before looking again, so the other side either sees the
+  // flag or made its change before that look. A wakeup can be left over
+  // from a wait that found ready() without sleeping, so sleep again until
+  // ready() holds or the time is up.
+  const auto deadline = std::chrono::steady_clock::now()
+                        + std::chrono::milliseconds(timeout_milliseconds);
+  waiting->store(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while (!ready()) {
+    int remaining = -1;
+    if (timeout_milliseconds >= 0) {
+      remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      deadline - std::chrono::steady_clock::now()).count();
+      if (remaining <= 0)
+        break;
+    }
+
+    ::pollfd event = {event_fd, POLLIN, 0};
+    ::poll(&event, 1, remaining);
+
+    std::uint64_t count;
+    if (::read(event_fd, &count, sizeof(count)) < 0) {
+      // nothing to drain
+    }
+  }
+  waiting->store(0);
+
+  return ready();
+}
+
+
+void SharedMemoryChannel::Signal(const std::atomic<std::uint32_t>& waiting,
+                                 int event_fd) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiting.load()) {
+    const std::uint64_t kOne = 1;
+    if (::write(event_fd, &kOne, sizeof(kOne)) < 0) {
+      // the counter is already set
+    }
+  }
+}
+
+
+void SharedMemoryChannel::CopyIn(Ring* ring,
+                                 std::uint64_t position,
+                                 const void* bytes,
+                                 std::size_t size) const {
+  char* data = reinterpret_cast<char*>(ring) + sizeof(Ring);
+  std::size_t offset = position & (capacity_ - 1);
+  std::size_t first = std::min<std::size_t>(size, capacity_ - offset);
+  std::memcpy(data + offset, bytes, first);
+  std::memcpy(data, static_cast<const char*>(bytes) + first, size - first);
+}
+
+
+void SharedMemoryChannel::CopyOut(const Ring* ring,
+                                  std::uint64_t position,
+                                  void* bytes,
+                                  std::size_t size) const {
+  const char* data = reinterpret_cast<const char*>(ring) + sizeof(Ring);
+  std::size_t offset = position & (capacity_ - 1);
+  std::size_t first = std::min<std::size_t>(size, capacity_ - offset);
+  std::memcpy(bytes, data + offset, first);
+  std::memcpy(static_cast<char*>(bytes) + first, data, size - first);
+}
@@ -0,0 +1,166 @@
+// Copyright 2025 CSCE 311
+//
+
+#include <uring.h>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+Uring::Uring()
+    : ring_fd_(-1), rings_(nullptr), rings_size_(0),
+      entries_(nullptr), entries_size_(0),
+      sq_head_(nullptr), sq_tail_(nullptr), sq_array_(nullptr),
+      sq_mask_(0), sq_entries_(0), prepared_tail_(0),
+      cq_head_(nullptr), cq_tail_(nullptr), completions_(nullptr),
+      cq_mask_(0) {
+  // empty
+}
+
+
+Uring::~Uring() {
+  Release();
+}
+
+
+void Uring::Release() {
+  if (entries_)
+    ::munmap(entries_, entries_size_);
+  if (rings_)
+    ::munmap(rings_, rings_size_);
+  if (ring_fd_ >= 0)
+    ::close(ring_fd_);
+
+  ring_fd_ = -1;
+  rings_ = nullptr;
+  entries_ = nullptr;
+}
+
+
+bool Uring::Init(unsigned entries) {
+  Release();
+
+  // Room for a burst of completions beyond the submissions in one round;
+  // the kernel keeps any overflow rather than dropping it
+  ::io_uring_params params = {};
+  params.flags = IORING_SETUP_CQSIZE
+                 | IORING_SETUP_SINGLE_ISSUER
+                 | IORING_SETUP_COOP_TASKRUN;
+  params.cq_entries = 4 * entries;
+  ring_fd_ = ::syscall(__NR_io_uring_setup, entries, &params);
+  if (ring_fd_ < 0 && errno == EINVAL) {
+    // Kernels before 6.0 know neither hint
+    params = {};
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = 4 * entries;
+    ring_fd_ = ::syscall(__NR_io_uring_setup, entries, &params);
+  }
+  if (ring_fd_ < 0)
+    return false;
+
+  const unsigned kNeeded = IORING_FEAT_SINGLE_MMAP
+                           | IORING_FEAT_NODROP
+                           | IORING_FEAT_EXT_ARG;
+  if ((params.features & kNeeded) != kNeeded) {
+    Release();
+    errno = ENOSYS;
+    return false;
+  }
+
+  rings_size_ = std::max(
+    params.sq_off.array + params.sq_entries * sizeof(unsigned),
+    params.cq_off.cqes + params.cq_entries * sizeof(::io_uring_cqe));
+  void* rings = ::mmap(nullptr, rings_size_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (rings == MAP_FAILED) {
+    int error = errno;
+    Release();
+    errno = error;
+    return false;
+  }
+  rings_ = rings;
+
+  entries_size_ = params.sq_entries * sizeof(::io_uring_sqe);
+  void* sqes = ::mmap(nullptr, entries_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    int error = errno;
+    Release();
+    errno = error;
+    return false;
+  }
+  entries_ = static_cast<::io_uring_sqe*>(sqes);
+
+  char* base = static_cast<char*>(rings_);
+  sq_head_ = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+  sq_array_ = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+  sq_mask_ = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+  sq_entries_ = params.sq_entries;
+  prepared_tail_ = *sq_tail_;
+
+  cq_head_ = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+  completions_ = reinterpret_cast<::io_uring_cqe*>(base + params.cq_off.cqes);
+  cq_mask_ = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+
+  return true;
+}
+
+
+::io_uring_sqe* Uring::Prepare() {
+  unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  if (prepared_tail_ - head >= sq_entries_)
+    return nullptr;
+
+  unsigned index = prepared_tail_ & sq_mask_;
+  sq_array_[index] = index;
+  ++prepared_tail_;
+
+  ::io_uring_sqe* entry = &entries_[index];
+  std::memset(entry, 0, sizeof(*entry));
+  return entry;
+}
+
+
+bool Uring::Submit(bool wait, int timeout_milliseconds) {
+  // Publish the prepared entries; the kernel takes everything between its
+  // head and the tail
+  __atomic_store_n(sq_tail_, prepared_tail_, __ATOMIC_RELEASE);
+  unsigned pending = prepared_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  if (pending == 0 && !wait)
+    return true;
+
+  ::__kernel_timespec timeout = {};
+  timeout.tv_sec = timeout_milliseconds / 1000;
+  timeout.tv_nsec = (timeout_milliseconds % 1000) * 1000000L;
+  ::io_uring_getevents_arg argument = {};
+  argument.ts = reinterpret_cast<std::uintptr_t>(&timeout);
+
+  unsigned flags = wait ? IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG : 0;
+  int result = ::syscall(__NR_io_uring_enter, ring_fd_, pending, wait ? 1 : 0,
+                         flags,
+                         wait ? &argument : nullptr,
+                         wait ? sizeof(argument) : 0);
+  return result >= 0
+         || errno == EINTR || errno == ETIME
+         || errno == EAGAIN || errno == EBUSY;  // try again next round
+}
+
+
+std::size_t Uring::Complete(::io_uring_cqe completions[], std::size_t count) {
+  unsigned head = *cq_head_;
+  unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+  std::size_t taken = 0;
+  for (; head != tail && taken < count; ++head, ++taken)
+    completions[taken] = completions_[head & cq_mask_];
+
+  __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+  return taken;
+}
@@ -0,0 +1,20 @@
+// Copyright 2025 CSCE 311
+//
+// The check every test program here makes: it prints whether a condition
+// held and what it checked, and counts the ones that did not, so main can
+// return failures == 0 ? 0 : 1.
+//
+#ifndef IPC_TEST_TEST_CHECK_H_
+#define IPC_TEST_TEST_CHECK_H_
+
+#include <iostream>
+
+inline int failures = 0;
+
+inline void Check(bool condition, const char* what) {
+  std::cout << (condition ? "PASSED: " : "FAILED: ") << what << std::endl;
+  if (!condition)
+    ++failures;
+}
+
+#endif  // IPC_TEST_TEST_CHECK_H_
@@ -0,0 +1,281 @@
+// Copyright 2025 CSCE 311
+//
+// Feeds a MessageReader through socket pairs: messages split across reads
+// and run together in one, frames holding the eot, packets larger than the
+// buffer, the end of the stream, and descriptors passed with SCM_RIGHTS.
+// The reader starts with a tiny buffer, so every test also makes it slide
+// and grow.
+
+#include <domain_socket.h>
+#include <test_check.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char kEot = '.';
+
+// Both ends of a socket pair, closed on destruction
+struct Pair {
+  int reader = -1;
+  int writer = -1;
+
+  explicit Pair(int type = SOCK_STREAM) {
+    int fds[2];
+    if (::socketpair(AF_UNIX, type, 0, fds) == 0) {
+      reader = fds[0];
+      writer = fds[1];
+    }
+  }
+
+  ~Pair() {
+    CloseWriter();
+    if (reader >= 0)
+      ::close(reader);
+  }
+
+  bool Send(const std::string& bytes) {
+    return ::send(writer, bytes.data(), bytes.size(), 0)
+           == static_cast<::ssize_t>(bytes.size());
+  }
+
+  void CloseWriter() {
+    if (writer >= 0)
+      ::close(writer);
+    writer = -1;
+  }
+};
+
+std::string Frame(const std::string& message) {
+  std::string frame;
+  for (std::size_t i = 0; i < MessageReader::kFrameHeader; ++i)
+    frame.push_back(static_cast<char>(message.size() >> (8 * i)));
+  return frame + message;
+}
+
+void TestSplitMessages() {
+  Pair pair;
+  MessageReader reader(4);
+  std::string_view message;
+
+  pair.Send("hel");
+  Check(reader.Fill(pair.reader) == 3 && !reader.Next(kEot, &message),
+        "a partial message is held back");
+  pair.Send("lo.wor");
+  Check(reader.Read(pair.reader, kEot, &message) == 6 && message == "hello",
+        "a message split across reads is joined");
+  pair.Send("ld.");
+  Check(reader.Read(pair.reader, kEot, &message) == 6 && message == "world",
+        "the rest of a message completes it");
+}
+
+void TestRunTogether() {
+  Pair pair;
+  MessageReader reader(4);
+  std::string_view message;
+
+  std::string sent;
+  for (int i = 0; i < 100; ++i)
+    sent += std::to_string(i) + kEot;
+  pair.Send(sent);
+
+  bool all = true;
+  for (int i = 0; i < 100 && all; ++i)
+    all = reader.Read(pair.reader, kEot, &message) > 0
+          && message == std::to_string(i);
+  Check(all && reader.Buffered() == 0,
+        "messages that arrive together come out one at a time");
+}
+
+void TestByteAtATime() {
+  Pair pair;
+  MessageReader reader(4);
+  std::string sent = std::string(1000, 'x') + kEot;
+
+  std::thread writer([&] {
+    for (char byte : sent)
+      pair.Send(std::string(1, byte));
+  });
+  std::string_view message;
+  ::ssize_t read = reader.Read(pair.reader, kEot, &message);
+  writer.join();
+  Check(read == 1001 && message == std::string(1000, 'x'),
+        "a message written a byte at a time grows the buffer");
+}
+
+void TestFrames() {
+  Pair pair;
+  MessageReader reader(4);
+  std::string_view message;
+
+  // The greeting and the first frame arrive in one read, before the switch
+  std::string binary = std::string("a.b") + '\0' + "c";
+  pair.Send(std::string("hi") + kEot + Frame(binary));
+  Check(reader.Read(pair.reader, kEot, &message) == 3 && message == "hi",
+        "the text message before the switch is read");
+  reader.UseFrames(true);
+  Check(reader.Read(pair.reader, kEot, &message) == 9 && message == binary,
+        "a frame may hold the eot and nul");
+
+  // Header and body each split across writes
+  std::string frame = Frame(std::string(300, 'y'));
+  std::thread writer([&] {
+    pair.Send(frame.substr(0, 2));
+    pair.Send(frame.substr(2, 100));
+    pair.Send(frame.substr(102));
+  });
+  bool split = reader.Read(pair.reader, kEot, &message) == 304
+               && message == std::string(300, 'y');
+  writer.join();
+  Check(split, "a frame split inside its header is joined");
+
+  pair.Send(Frame(""));
+  Check(reader.Read(pair.reader, kEot, &message) == 4 && message.empty(),
+        "an empty frame is a message");
+}
+
+void TestByteCount() {
+  Pair pair;
+  MessageReader reader(4);
+  std::string_view bytes;
+
+  pair.Send("abcdefgh.rest.");
+  Check(reader.Read(pair.reader, std::size_t(8), &bytes) == 8 && bytes == "abcdefgh",
+        "exactly byte_count bytes are returned");
+  Check(reader.Read(pair.reader, kEot, &bytes) == 1 && bytes.empty(),
+        "reading resumes after them");
+  Check(reader.Read(pair.reader, kEot, &bytes) == 5 && bytes == "rest",
+        "the next message follows");
+}
+
+void TestEndOfStream() {
+  Pair pair;
+  MessageReader reader(4);
+  std::string_view message;
+
+  pair.Send("last.unfinished");
+  pair.CloseWriter();
+  Check(reader.Read(pair.reader, kEot, &message) == 5 && message == "last",
+        "messages before the end are read");
+  Check(reader.Read(pair.reader, kEot, &message) == 0,
+        "an unfinished message at the end reads as a disconnect");
+}
+
+void TestPackets() {
+  Pair pair(SOCK_SEQPACKET);
+  MessageReader reader(4);
+  std::string_view message;
+
+  std::string large = std::string(5000, 'z') + kEot;
+  pair.Send(std::string("ab") + kEot);
+  pair.Send(large);
+  pair.Send(std::string("c.d") + kEot);
+  Check(reader.Read(pair.reader, kEot, &message) == 3 && message == "ab",
+        "a packet is one message");
+  Check(reader.Read(pair.reader, kEot, &message) == 5001
+        && message == std::string(5000, 'z'),
+        "a packet larger than the buffer arrives whole");
+  Check(reader.Read(pair.reader, kEot, &message) == 4 && message == "c.d",
+        "an eot inside a packet is not scanned for");
+
+  reader.UseFrames(true);
+  pair.Send(Frame("one") + Frame("two"));
+  bool first = reader.Read(pair.reader, kEot, &message) > 0 && message == "one";
+  Check(first && reader.Read(pair.reader, kEot, &message) > 0 && message == "two",
+        "frames are read from packets");
+}
+
+// Sends bytes with the given descriptors attached
+bool SendDescriptors(int socket_fd, const std::string& bytes,
+                     const std::vector<int>& descriptors) {
+  ::iovec buffer = {const_cast<char*>(bytes.data()), bytes.size()};
+  alignas(::cmsghdr) char control[MessageReader::kControlBytes] = {};
+  ::msghdr header = {};
+  header.msg_iov = &buffer;
+  header.msg_iovlen = 1;
+  header.msg_control = control;
+  header.msg_controllen = CMSG_SPACE(descriptors.size() * sizeof(int));
+
+  ::cmsghdr* rights = CMSG_FIRSTHDR(&header);
+  rights->cmsg_level = SOL_SOCKET;
+  rights->cmsg_type = SCM_RIGHTS;
+  rights->cmsg_len = CMSG_LEN(descriptors.size() * sizeof(int));
+  std::memcpy(CMSG_DATA(rights), descriptors.data(),
+              descriptors.size() * sizeof(int));
+  return ::sendmsg(socket_fd, &header, 0)
+         == static_cast<::ssize_t>(bytes.size());
+}
+
+// True if what is written to write_fd can be read from read_fd
+bool Connected(int write_fd, int read_fd) {
+  char byte = 0;
+  return ::write(write_fd, "!", 1) == 1 && ::read(read_fd, &byte, 1) == 1
+         && byte == '!';
+}
+
+void TestDescriptors() {
+  Pair pair;
+  MessageReader reader(4);
+  std::string_view message;
+
+  int pipe_fds[2];
+  if (::pipe(pipe_fds) < 0)
+    return Check(false, "create a pipe to pass");
+  bool sent = SendDescriptors(pair.writer, std::string("fd") + kEot,
+                              {pipe_fds[0], pipe_fds[1]});
+  ::close(pipe_fds[0]);
+  ::close(pipe_fds[1]);
+  Check(sent && reader.Read(pair.reader, kEot, &message) == 3
+        && message == "fd",
+        "a message carrying descriptors is read");
+
+  std::vector<int> received = reader.TakeDescriptors();
+  Check(received.size() == 2 && Connected(received[1], received[0]),
+        "the descriptors arrive in order and still work");
+  Check(reader.TakeDescriptors().empty(), "descriptors are taken once");
+  for (int fd : received)
+    ::close(fd);
+
+  // The same, read in two halves as an io_uring caller would
+  if (::pipe(pipe_fds) < 0)
+    return Check(false, "create a pipe to pass");
+  sent = SendDescriptors(pair.writer, std::string("two") + kEot, {pipe_fds[0]});
+  ::close(pipe_fds[0]);
+  ::close(pipe_fds[1]);
+
+  ::msghdr header;
+  ::iovec buffer;
+  alignas(::cmsghdr) char control[MessageReader::kControlBytes];
+  reader.PrepareFill(pair.reader, &header, &buffer, control);
+  ::ssize_t bytes_read = ::recvmsg(pair.reader, &header, MSG_CMSG_CLOEXEC);
+  bool halves = sent && reader.FinishFill(header, bytes_read) == 4
+                && reader.Next(kEot, &message) && message == "two";
+  received = reader.TakeDescriptors();
+  Check(halves && received.size() == 1,
+        "PrepareFill and FinishFill keep descriptors too");
+  for (int fd : received)
+    ::close(fd);
+}
+
+}  // namespace
+
+int main() {
+  TestSplitMessages();
+  TestRunTogether();
+  TestByteAtATime();
+  TestFrames();
+  TestByteCount();
+  TestEndOfStream();
+  TestPackets();
+  TestDescriptors();
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,297 @@
+// Copyright 2025 CSCE 311
+//
+// Runs both ends of a SharedMemoryChannel in one process. Messages must
+// survive wrapping around the end of a small ring, with both ends taking
+// turns or running on threads of their own, and Close must reach whichever
+// end is waiting. The server end must also treat the shared rings as
+// untrusted: a client that rewrites a message's length, its ring's head or
+// its capacity must not make the server read outside the mapping or
+// allocate what the length claims, and one that stops reading must not hold
+// the server's Send forever. Neither end may resize the memfd.
+
+#include <shared_memory_channel.h>
+#include <test_check.h>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// A client end and a server end attached to copies of its descriptors
+struct Pair {
+  SharedMemoryChannel client;
+  SharedMemoryChannel server;
+
+  bool Open(std::size_t capacity = 4096) {
+    if (!client.Create(capacity))
+      return false;
+
+    std::vector<int> copies;
+    for (int fd : client.Descriptors())
+      copies.push_back(::dup(fd));
+    return server.Attach(copies);
+  }
+};
+
+// The whole memfd, as the client could map it
+class Mapping {
+ public:
+  explicit Mapping(const SharedMemoryChannel& channel)
+      : size_(0), bytes_(nullptr) {
+    int fd = channel.Descriptors()[0];
+    size_ = ::lseek(fd, 0, SEEK_END);
+    void* bytes = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                         fd, 0);
+    if (bytes != MAP_FAILED)
+      bytes_ = static_cast<char*>(bytes);
+  }
+
+  ~Mapping() {
+    if (bytes_)
+      ::munmap(bytes_, size_);
+  }
+
+  // Offset of the first copy of pattern in the client-to-server ring's half,
+  // or -1
+  std::ptrdiff_t Find(const std::string& pattern) const {
+    if (!bytes_)
+      return -1;
+    for (std::size_t i = 0; i + pattern.size() <= size_ / 2; ++i)
+      if (std::memcmp(bytes_ + i, pattern.data(), pattern.size()) == 0)
+        return i;
+    return -1;
+  }
+
+  template <typename T>
+  void Store(std::ptrdiff_t offset, T value) {
+    std::memcpy(bytes_ + offset, &value, sizeof(value));
+  }
+
+ private:
+  std::size_t size_;
+  char* bytes_;
+};
+
+template <typename T>
+std::string Bytes(T value) {
+  return std::string(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void TestRoundTrip() {
+  Pair pair;
+  std::string message;
+  Check(pair.Open() && pair.client.Send("hello")
+        && pair.server.Receive(&message, 0) == 1 && message == "hello",
+        "a message crosses the channel");
+}
+
+// A message of length bytes that differs from its neighbours
+std::string Message(std::size_t i, std::size_t length) {
+  std::string message(length, static_cast<char>('a' + i % 26));
+  if (length > 0)
+    message[0] = static_cast<char>(i);
+  return message;
+}
+
+void TestWraparound() {
+  // 64 bytes a ring: messages and their lengths straddle the end at every
+  // offset as the sizes cycle
+  Pair pair;
+  if (!pair.Open(64))
+    return Check(false, "open a small channel");
+
+  std::string message;
+  bool intact = true;
+  for (std::size_t i = 0; i < 1000 && intact; ++i) {
+    std::string sent = Message(i, i % 61);
+    intact = pair.client.Send(sent) && pair.server.Receive(&message, 0) == 1
+             && message == sent;
+  }
+  Check(intact, "messages wrap around the end of the ring");
+
+  Check(pair.client.Send(std::string(60, 'x'))
+        && pair.server.Receive(&message, 0) == 1 && message.size() == 60,
+        "a message filling the whole ring fits");
+  Check(!pair.client.Send(std::string(61, 'x')),
+        "a message larger than the ring is refused");
+  Check(pair.server.Receive(&message, 10) == 0,
+        "Receive times out on an empty ring");
+
+  pair.server.Send(std::string(60, 'x'));
+  Check(!pair.server.Send("more", 10), "Send times out on a full ring");
+}
+
+void TestThreads() {
+  // The writer keeps filling the ring, so both ends end up sleeping on
+  // their eventfds
+  const std::size_t kMessages = 20000;
+  Pair pair;
+  if (!pair.Open(256))
+    return Check(false, "open a channel for two threads");
+
+  std::thread writer([&] {
+    for (std::size_t i = 0; i < kMessages; ++i)
+      pair.client.Send(Message(i, i % 200));
+  });
+
+  std::string message;
+  bool intact = true;
+  for (std::size_t i = 0; i < kMessages && intact; ++i)
+    intact = pair.server.Receive(&message, -1) == 1
+             && message == Message(i, i % 200);
+  writer.join();
+  Check(intact, "messages from another thread arrive in order");
+
+  // The server replies the same way
+  std::thread replier([&] {
+    for (std::size_t i = 0; i < kMessages; ++i)
+      pair.server.Send(Message(i, i % 100));
+  });
+  intact = true;
+  for (std::size_t i = 0; i < kMessages && intact; ++i)
+    intact = pair.client.Receive(&message, -1) == 1
+             && message == Message(i, i % 100);
+  replier.join();
+  Check(intact, "replies from another thread arrive in order");
+}
+
+void TestClose() {
+  Pair pair;
+  std::string message;
+  if (!pair.Open())
+    return Check(false, "open a channel to close");
+
+  pair.client.Send("one");
+  pair.client.Send("two");
+  pair.client.Close();
+  bool drained = pair.server.Receive(&message, 0) == 1 && message == "one"
+                 && pair.server.Receive(&message, 0) == 1 && message == "two";
+  Check(drained && pair.server.Receive(&message, 0) == -1,
+        "messages sent before Close are drained, then Receive fails");
+  Check(!pair.server.Send("reply") && !pair.client.Send("more"),
+        "neither end can send once closed");
+
+  // A receiver asleep on an empty ring is woken
+  Pair waiting;
+  if (!waiting.Open())
+    return Check(false, "open a channel to close");
+  int received = 0;
+  std::thread receiver([&] { received = waiting.server.Receive(&message, -1); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  waiting.client.Close();
+  receiver.join();
+  Check(received == -1, "Close wakes a waiting receiver");
+
+  // As is a sender asleep on a full ring
+  Pair full;
+  if (!full.Open(64))
+    return Check(false, "open a channel to close");
+  bool sent = true;
+  std::thread sender([&] {
+    for (int i = 0; i < 100 && sent; ++i)
+      sent = full.client.Send(std::string(40, 'x'));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  full.server.Close();
+  sender.join();
+  Check(!sent, "Close wakes a sender waiting for room");
+}
+
+void TestSealed() {
+  Pair pair;
+  if (!pair.Open())
+    return Check(false, "open a channel to resize");
+  int fd = pair.client.Descriptors()[0];
+  Check(::ftruncate(fd, 0) < 0 && ::ftruncate(fd, 1 << 20) < 0,
+        "the memfd cannot shrink or grow");
+
+  // The same layout without the seals is refused
+  SharedMemoryChannel unsealed;
+  std::vector<int> descriptors = {::memfd_create("unsealed", MFD_CLOEXEC)};
+  for (std::size_t i = 1; i < SharedMemoryChannel::kDescriptors; ++i)
+    descriptors.push_back(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+  Check(::ftruncate(descriptors[0], ::lseek(fd, 0, SEEK_END)) == 0
+        && !unsealed.Attach(descriptors),
+        "a memfd without seals is refused");
+}
+
+void TestCorruptLength() {
+  Pair pair;
+  if (!pair.Open() || !pair.client.Send("hello"))
+    return Check(false, "open a channel to corrupt");
+
+  Mapping mapping(pair.client);
+  std::ptrdiff_t length = mapping.Find(Bytes<std::uint32_t>(5) + "hello");
+  Check(length >= 0, "find the message's length in the ring");
+  if (length < 0)
+    return;
+  mapping.Store<std::uint32_t>(length, 0xFFFFFFFF);
+
+  std::string message;
+  Check(pair.server.Receive(&message, 0) == -1,
+        "a length past what was written closes the channel");
+  Check(!pair.client.Send("more"), "the client sees the channel closed");
+}
+
+void TestCorruptHead() {
+  Pair pair;
+  if (!pair.Open() || !pair.client.Send("hello"))
+    return Check(false, "open a channel to corrupt");
+
+  // The ring's head, the bytes ever written, is its first field
+  Mapping mapping(pair.client);
+  std::uint64_t written = sizeof(std::uint32_t) + 5;
+  Check(mapping.Find(Bytes(written)) == 0, "find the ring's head");
+  mapping.Store<std::uint64_t>(0, written + (1 << 20));
+
+  std::string message;
+  Check(pair.server.Receive(&message, 0) == -1,
+        "a head more than a ring ahead closes the channel");
+}
+
+void TestCorruptCapacity() {
+  Pair pair;
+  if (!pair.Open())
+    return Check(false, "open a channel to corrupt");
+
+  // Growing the ring's capacity after Attach must not move where the
+  // server reads from
+  Mapping mapping(pair.client);
+  std::ptrdiff_t capacity = mapping.Find(Bytes<std::uint64_t>(4096));
+  Check(capacity >= 0, "find the ring's capacity");
+  if (capacity < 0)
+    return;
+  mapping.Store<std::uint64_t>(capacity, std::uint64_t(1) << 40);
+
+  std::string message;
+  bool intact = true;
+  for (int i = 0; i < 1000 && intact; ++i) {
+    std::string sent = "message " + std::to_string(i);
+    intact = pair.client.Send(sent) && pair.server.Receive(&message, 0) == 1
+             && message == sent;
+  }
+  Check(intact, "messages survive a rewritten capacity");
+}
+
+}  // namespace
+
+int main() {
+  TestRoundTrip();
+  TestWraparound();
+  TestThreads();
+  TestClose();
+  TestSealed();
+  TestCorruptLength();
+  TestCorruptHead();
+  TestCorruptCapacity();
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+#ifndef BOOL_EXPR_PROTOCOL_H_
+#define BOOL_EXPR_PROTOCOL_H_
+
+#include <bool_expr_parser.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Message framing shared by bool-expr-client and bool-expr-server, on top
+// of the unit separator and eot characters the server hands out.
+//
+// A plain request is one set of truth values, e.g., "T:F:T", and its reply
+// is "<n>T:<n>F:<n>E".
+//
+// A batch request starts with kBatchMarker and carries many sets of truth
+// values separated by kBatchSeparator, e.g., "*T:F\nF:F:T". Its reply holds
+// one "<n>T:<n>F:<n>E" per set, in the same order, separated the same way.
+// The server evaluates up to 64 sets in a single pass over the expressions.
+//
+// A ring request is kRingMarker alone, sent with the three descriptors of a
+// SharedMemoryChannel the client created. The server replies kRingMarker
+// and from then on answers every request the client sends through the
+// channel, replying through it the same way; an empty reply means the
+// channel was refused and the client stays on the socket.
+//
+// Upload requests pass their payload as a descriptor (a file or memfd)
+// instead of through the socket, and the server maps it and reads it in
+// place:
+//
+// kUploadMarker alone, with a file holding a batch (sets of truth values
+// separated by kBatchSeparator), is answered as that batch. If a second
+// file is passed, the batch reply is written there instead and the reply
+// on the socket is kUploadMarker followed by its size, e.g., "&1234".
+//
+// kExpressionsMarker followed by a plain or batch request, with an
+// expression file (text, or a table from bool-expr-convert), is answered
+// against those expressions instead of the server's.
+//
+// Binary protocol: a server that speaks it ends its configuration with
+// kBinaryMarker and the version, e.g., ":.#1." rather than ":..". A client
+// that sees the offer may send those two bytes back, and every message
+// after them on the connection, over the socket or a ring, is binary. The
+// server echoes the two bytes as text before its first binary reply, so
+// the client need not wait for the echo before sending requests. On the
+// socket a binary message is a frame, its length as a little-endian 32-bit
+// integer and then its bytes, with no eot.
+//
+// A binary request is one or more truth assignments of kAssignmentBytes
+// each: the mask of variables given, then the mask of those that are true
+// (bit 0 for a, bit 1 for b, ...), as little-endian 32-bit integers. Its
+// reply holds kCountsBytes per assignment, in the same order: the true,
+// false and error counts as little-endian 32-bit integers. One assignment
+// is answered like a plain request, more like a batch.
+
+const char kBatchMarker = '*';
+const char kBatchSeparator = '\n';
+const char kRingMarker = '@';
+const char kUploadMarker = '&';
+const char kExpressionsMarker = '%';
+const char kBinaryMarker = '#';
+const char kBinaryVersion = '1';
+
+const std::size_t kAssignmentBytes = 8;
+const std::size_t kCountsBytes = 12;
+
+// The numbers a reply carries for one set of truth values
+struct ResultCounts {
+    int true_count;
+    int false_count;
+    int error_count;
+};
+
+inline void AppendUint32(std::uint32_t value, std::string* out) {
+    for (int i = 0; i < 4; ++i) out->push_back(static_cast<char>(value >> (8 * i)));
+}
+
+inline std::uint32_t ReadUint32(const char* in) {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) value |= std::uint32_t(static_cast<unsigned char>(in[i])) << (8 * i);
+    return value;
+}
+
+inline void AppendAssignment(const TruthAssignment& assignment, std::string* out) {
+    AppendUint32(assignment.defined, out);
+    AppendUint32(assignment.values, out);
+}
+
+// Reads kAssignmentBytes
+inline TruthAssignment ReadAssignment(const char* in) {
+    TruthAssignment assignment;
+    assignment.defined = ReadUint32(in);
+    assignment.values = ReadUint32(in + 4);
+    return assignment;
+}
+
+inline void AppendCounts(const ResultCounts& counts, std::string* out) {
+    AppendUint32(counts.true_count, out);
+    AppendUint32(counts.false_count, out);
+    AppendUint32(counts.error_count, out);
+}
+
+// Reads kCountsBytes
+inline ResultCounts ReadCounts(const char* in) {
+    ResultCounts counts;
+    counts.true_count = ReadUint32(in);
+    counts.false_count = ReadUint32(in + 4);
+    counts.error_count = ReadUint32(in + 8);
+    return counts;
+}
+
+#endif  // BOOL_EXPR_PROTOCOL_H_
@@ -1,10 +1,51 @@
 #ifndef BOOL_EXPR_SERVER_H_
 #define BOOL_EXPR_SERVER_H_
 
+#include <cstddef>
 #include <string>
 
+// Optional server behaviour, set from the command line
+struct ServerOptions {
+    // Multiplex all clients on one thread with epoll instead of serving
+    // them one at a time
+    bool event_loop = false;
+
+    // Run that event loop on io_uring rather than epoll, where the kernel
+    // allows
+    bool io_uring = false;
+
+    // Evaluator threads each request's expressions are split across
+    std::size_t threads = 1;
+
+    // Most results kept in the server's cache; 0, the default, disables it
+    std::size_t cache_size = 0;
+
+    // Size the cache gets from a bare --cache
+    static const std::size_t kDefaultCacheSize = 4096;
+
+    // Answer requests from a precomputed truth table index, when the
+    // expressions use few enough variables for one
+    bool index = false;
+
+    // Where the index is kept between runs; empty builds it on every start
+    std::string index_path;
+
+    // Remember each client's last assignment and per-expression results,
+    // and re-evaluate only the expressions using variables it changed
+    bool delta = false;
+
+    // Evaluate a request from an index of the expressions' product terms,
+    // visiting only the terms its assignment satisfies
+    bool term_index = false;
+
+    // Listen on a SOCK_SEQPACKET socket, where the kernel keeps each
+    // message's boundaries, instead of a byte stream
+    bool packets = false;
+};
+
 // Function declaration for the server start function
 int start_server(const std::string& file_path, const std::string& server_name, 
-                 char unit_separator, char eot);
+                 char unit_separator, char eot,
+                 const ServerOptions& options = ServerOptions());
 
-#endif  // BOOL_EXPR_SERVER_H_
\ No newline at end of file
+#endif  // BOOL_EXPR_SERVER_H_
@@ -0,0 +1,61 @@
+#ifndef DELTA_EVALUATOR_H_
+#define DELTA_EVALUATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <bool_expr_parser.h>
+#include <bool_expr_protocol.h>
+#include <bool_expr_table.h>
+
+// One client's last assignment and the result it gave each expression
+struct DeltaState {
+    bool valid = false;
+    std::uint64_t generation = 0;  // of the table the results are for
+    TruthAssignment assignment = {0, 0};
+    std::vector<std::uint8_t> results;  // a DeltaEvaluator::Result each
+    ResultCounts counts = {0, 0, 0};
+};
+
+// Answers a request that changes only a few variables since the client's
+// last one by re-evaluating just the expressions that use them, found in
+// an inverted index from each variable to the expressions containing it.
+// Every other expression keeps its previous result, and the counts are
+// adjusted by the results that changed.
+class DeltaEvaluator {
+public:
+    enum Result : std::uint8_t { kFalse, kTrue, kError };
+
+    // Indexes the expressions of table, which must outlive the evaluator
+    explicit DeltaEvaluator(const ExpressionTable& table);
+
+    // Brings state up to date with assignment and sets counts. Returns
+    // false, leaving state untouched, if state holds no results for the
+    // table as it is now, or if so many expressions are affected that
+    // evaluating them all is cheaper.
+    bool Update(const TruthAssignment& assignment, DeltaState* state,
+                ResultCounts* counts) const;
+
+    // Marks state as holding the results of a full evaluation of
+    // assignment; state->results must already hold every expression's
+    // result, totalling counts
+    void Record(const TruthAssignment& assignment, const ResultCounts& counts,
+                DeltaState* state) const;
+
+private:
+    const ExpressionTable& table_;
+    std::uint64_t generation_;  // of table_ when it was indexed
+    
+    // Expressions using variable j are users_[offsets_[j]] up to
+    // users_[offsets_[j + 1]]; those that did not compile are in none
+    std::vector<std::uint32_t> offsets_;
+    std::vector<std::uint32_t> users_;
+    std::vector<std::uint32_t> variables_;  // each expression's, as a bitmask
+
+    // Non-copyable
+    DeltaEvaluator(const DeltaEvaluator&) = delete;
+    DeltaEvaluator& operator=(const DeltaEvaluator&) = delete;
+};
+
+#endif  // DELTA_EVALUATOR_H_
@@ -0,0 +1,62 @@
+#ifndef EVALUATOR_POOL_H_
+#define EVALUATOR_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of threads that split one range of work between them. The
+// server shards each request's expressions across the pool, so a single
+// request uses every thread and requests still finish in arrival order.
+class EvaluatorPool {
+public:
+    // Work on [begin, end); shard is the caller's index in [0, Size())
+    typedef std::function<void(std::size_t begin, std::size_t end,
+                               std::size_t shard)> Task;
+
+    // Starts n_threads - 1 workers; the calling thread is the last one
+    explicit EvaluatorPool(std::size_t n_threads);
+
+    // Stops and joins the workers
+    ~EvaluatorPool();
+
+    // Splits [0, n) into Size() contiguous shards and runs task on each,
+    // one per thread, returning once all are done. Ranges shorter than
+    // min_shard per thread run on the calling thread alone, as does the
+    // whole range (shard 0) when another thread's job already has the
+    // workers, so any number of threads may call Run at once.
+    void Run(std::size_t n, const Task& task, std::size_t min_shard = kMinShard);
+
+    std::size_t Size() const {
+        return workers_.size() + 1;
+    }
+
+    // Fewer expressions than this per thread are not worth a wakeup
+    static const std::size_t kMinShard = 1024;
+
+private:
+    void Work(std::size_t shard);
+
+    std::vector<std::thread> workers_;
+
+    std::mutex running_;  // held by the caller whose job the workers run
+
+    std::mutex mutex_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    // Current job, guarded by mutex_; generation_ changes for every job
+    const Task* task_;
+    std::size_t n_;
+    std::size_t generation_;
+    std::size_t pending_;
+    bool stopping_;
+
+    // Non-copyable
+    EvaluatorPool(const EvaluatorPool&) = delete;
+    EvaluatorPool& operator=(const EvaluatorPool&) = delete;
+};
+
+#endif  // EVALUATOR_POOL_H_
@@ -0,0 +1,69 @@
+#ifndef RESULT_CACHE_H_
+#define RESULT_CACHE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <bool_expr_protocol.h>
+
+// A bounded cache of evaluation results keyed by packed truth assignment.
+// Entries are replaced with the CLOCK policy: each slot has a reference bit
+// that a hit sets, and the hand sweeps the slots, clearing set bits and
+// evicting the first entry whose bit is already clear. That approximates
+// LRU without reordering anything on a hit.
+//
+// Every entry belongs to a generation of the expression set (see
+// ExpressionTable::Generation); the whole cache is dropped as soon as it
+// is used with a different one. All methods are safe to call concurrently.
+class ResultCache {
+public:
+    typedef ResultCounts Counts;
+
+    // Holds at most capacity entries; 0 disables the cache
+    explicit ResultCache(std::size_t capacity);
+
+    // Finds the counts stored for key, if any
+    bool Lookup(std::uint64_t key, std::uint64_t generation, Counts* counts);
+
+    // Stores counts for key, evicting an entry if the cache is full
+    void Insert(std::uint64_t key, std::uint64_t generation, const Counts& counts);
+
+    std::uint64_t Hits() const {
+        return hits_;
+    }
+
+    std::uint64_t Misses() const {
+        return misses_;
+    }
+
+private:
+    struct Slot {
+        std::uint64_t key;
+        Counts counts;
+        bool referenced;
+    };
+
+    // Empties the cache if it holds another generation. Needs mutex_.
+    void Synchronize(std::uint64_t generation);
+
+    const std::size_t capacity_;
+
+    std::mutex mutex_;
+    std::vector<Slot> slots_;  // grows to capacity_, then entries are replaced
+    std::unordered_map<std::uint64_t, std::size_t> index_;  // key to slot
+    std::size_t hand_;
+    std::uint64_t generation_;
+
+    std::atomic<std::uint64_t> hits_;
+    std::atomic<std::uint64_t> misses_;
+
+    // Non-copyable
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+};
+
+#endif  // RESULT_CACHE_H_
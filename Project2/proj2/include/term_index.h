@@ -0,0 +1,64 @@
+#ifndef TERM_INDEX_H_
+#define TERM_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <bool_expr_parser.h>
+#include <bool_expr_protocol.h>
+#include <bool_expr_table.h>
+
+// Counts an assignment's results from the product terms it satisfies,
+// instead of scanning every term of every expression. A term over the
+// variables in mask holds exactly when the assignment's values restricted
+// to mask equal the term's positive literals, so the terms are grouped by
+// mask and sorted by positive literals: each group is one binary search,
+// and only terms that hold are ever visited. An expression is true once
+// any of its terms is found, and an error when it uses a variable the
+// assignment leaves undefined, which is settled per distinct set of
+// variables rather than per expression.
+class TermIndex {
+public:
+    // Indexes the terms of table, which must outlive the index
+    explicit TermIndex(const ExpressionTable& table);
+
+    // Counts the expressions assignment makes true, false and errors, as
+    // evaluating each one would. Returns false if the table has changed
+    // since it was indexed. Safe to call concurrently.
+    bool Evaluate(const TruthAssignment& assignment, ResultCounts* counts) const;
+
+private:
+    struct Entry {
+        std::uint32_t positive;
+        std::uint32_t expression;
+    };
+
+    // Terms over exactly the variables in mask are entries_[begin, end)
+    struct Group {
+        std::uint32_t mask;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    // How many expressions use exactly the variables in mask
+    struct Usage {
+        std::uint32_t mask;
+        std::size_t count;
+    };
+
+    const ExpressionTable& table_;
+    std::uint64_t generation_;  // of table_ when it was indexed
+
+    std::vector<Entry> entries_;
+    std::vector<Group> groups_;
+    std::vector<Usage> usages_;
+    std::vector<std::uint32_t> variables_;  // each expression's, as a bitmask
+    std::size_t n_errors_;  // expressions that did not compile
+
+    // Non-copyable
+    TermIndex(const TermIndex&) = delete;
+    TermIndex& operator=(const TermIndex&) = delete;
+};
+
+#endif  // TERM_INDEX_H_
@@ -0,0 +1,99 @@
+#ifndef TRUTH_TABLE_INDEX_H_
+#define TRUTH_TABLE_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <bool_expr_parser.h>
+#include <bool_expr_protocol.h>
+#include <bool_expr_table.h>
+#include <evaluator_pool.h>
+
+// The answer to every possible request, precomputed for an expression set
+// that uses only the first n variables. A request's truth values define a
+// prefix a, b, ... of length L, so for each L and each of its 2^L value
+// combinations the index stores how many expressions evaluate true. An
+// expression errors exactly when it uses a variable past the prefix, so
+// the error count depends on L alone, and the false count is what is left.
+// Every lookup is then a single array access.
+//
+// Index file layout, all fields in host byte order (as ExpressionTable's):
+//
+//   char     magic[4]        "BXPI"
+//   uint32_t version         kVersion
+//   uint32_t n_variables     n
+//   uint32_t n_expressions
+//   uint64_t fingerprint     of the expression table the index describes
+//   uint32_t error_counts[n + 1]            by prefix length L
+//   uint32_t true_counts[2^(n + 1) - 1]     prefix length L's 2^L entries
+//                                            start at 2^L - 1
+class TruthTableIndex {
+public:
+    static const std::uint32_t kVersion = 1;
+
+    // Largest n worth indexing; the index holds 2^(n + 1) counts
+    static const std::size_t kMaxVariables = 22;
+
+    TruthTableIndex();
+
+    // Unmaps the file if the index was loaded
+    ~TruthTableIndex();
+
+    // Computes the index for table, evaluating 64 assignments at a time
+    // across the pool's threads. Fails if the table uses more than
+    // max_variables variables.
+    bool Build(const ExpressionTable& table, EvaluatorPool& pool,
+               std::size_t max_variables = kMaxVariables);
+
+    // Maps an index written by Save, if it describes table
+    bool Load(const std::string& path, const ExpressionTable& table);
+
+    bool Save(const std::string& path) const;
+
+    // Finds the counts for an assignment to the expression set of the given
+    // generation. Returns false if the index is for another generation or
+    // the assignment does not define a prefix of the variables.
+    bool Lookup(std::uint64_t generation, const TruthAssignment& assignment,
+                ResultCounts* counts) const;
+
+    // Number of variables indexed
+    std::size_t Variables() const {
+        return n_variables_;
+    }
+
+    // Describes why the last Build, Load or Save failed
+    const std::string Error() const {
+        return err_msg_;
+    }
+
+private:
+    // Releases any mapping and empties the index
+    void Clear();
+
+    // Identifies the contents of table, so a saved index can be matched
+    static std::uint64_t Fingerprint(const ExpressionTable& table);
+
+    std::vector<std::uint32_t> owned_error_counts_;
+    std::vector<std::uint32_t> owned_true_counts_;
+
+    void* mapping_;
+    std::size_t mapping_size_;
+
+    bool valid_;
+    std::uint64_t generation_;  // of the table the index describes
+    std::uint64_t fingerprint_;
+    std::size_t n_variables_;
+    std::size_t n_expressions_;
+    const std::uint32_t* error_counts_;
+    const std::uint32_t* true_counts_;
+
+    mutable std::string err_msg_;
+
+    // Non-copyable
+    TruthTableIndex(const TruthTableIndex&) = delete;
+    TruthTableIndex& operator=(const TruthTableIndex&) = delete;
+};
+
+#endif  // TRUTH_TABLE_INDEX_H_
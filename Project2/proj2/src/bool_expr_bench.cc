@@ -0,0 +1,153 @@
+// Times the server's ways of evaluating a whole expression set against one
+// truth assignment, on random assignments, and checks they agree:
+//
+//   scan   every term of every expression (ExpressionTable::Evaluate)
+//   batch  every term once per 64 assignments (bit-sliced)
+//   terms  only the terms that hold (TermIndex)
+//
+// Usage: bool-expr-bench <expressions_file> [assignments]
+//
+
+#include <bool_expr_compiler.h>
+#include <bool_expr_parser.h>
+#include <bool_expr_protocol.h>
+#include <bool_expr_table.h>
+#include <term_index.h>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+ResultCounts Scan(const ExpressionTable& table, const TruthAssignment& assignment) {
+    ResultCounts counts = {0, 0, 0};
+    for (std::size_t i = 0; i < table.Size(); ++i) {
+        bool error = false;
+        bool result = table.Evaluate(i, assignment, &error);
+        if (error) {
+            counts.error_count++;
+        } else if (result) {
+            counts.true_count++;
+        } else {
+            counts.false_count++;
+        }
+    }
+    return counts;
+}
+
+void Batch(const ExpressionTable& table, const std::vector<TruthAssignment>& assignments,
+           std::vector<ResultCounts>* results) {
+    for (std::size_t first = 0; first < assignments.size(); first += AssignmentBatch::kMaxSize) {
+        AssignmentBatch batch;
+        for (std::size_t k = first; k < assignments.size() && batch.Add(assignments[k]); ++k) {
+            // added
+        }
+        
+        SlicedCounter true_counts, error_counts;
+        for (std::size_t i = 0; i < table.Size(); ++i) {
+            std::uint64_t errors;
+            true_counts.Add(table.Evaluate(i, batch, &errors));
+            error_counts.Add(errors);
+        }
+        
+        for (std::size_t k = 0; k < batch.size; ++k) {
+            ResultCounts& counts = (*results)[first + k];
+            counts.true_count = true_counts.Count(k);
+            counts.error_count = error_counts.Count(k);
+            counts.false_count = table.Size() - counts.true_count - counts.error_count;
+        }
+    }
+}
+
+bool Same(const ResultCounts& a, const ResultCounts& b) {
+    return a.true_count == b.true_count && a.false_count == b.false_count
+        && a.error_count == b.error_count;
+}
+
+// Times one run of method, reporting microseconds per assignment
+template <typename Method>
+void Time(const char* name, std::size_t n_assignments, Method method) {
+    auto start = std::chrono::steady_clock::now();
+    method();
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "  " << name << ": " << elapsed.count() / n_assignments
+              << " us/assignment" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 2 && argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <expressions_file> [assignments]" << std::endl;
+        return 1;
+    }
+    
+    // Load expressions as the server does
+    ExpressionTable table;
+    std::ifstream file(argv[1]);
+    if (file.is_open() && ExpressionTable::IsBinary(argv[1])) {
+        if (!table.Load(argv[1])) {
+            std::cerr << table.Error() << std::endl;
+            return 1;
+        }
+    } else if (file.is_open()) {
+        std::string line;
+        while (std::getline(file, line)) {
+            std::string exploded = Explode(line.c_str(), ' ');
+            if (!exploded.empty()) table.Append(CompiledExpression(exploded));
+        }
+    } else {
+        std::cerr << "Unable to open file: " << argv[1] << std::endl;
+        return 1;
+    }
+    
+    std::size_t n_assignments = argc == 3 ? std::stoul(argv[2]) : 1000;
+    
+    auto build_start = std::chrono::steady_clock::now();
+    TermIndex terms(table);
+    std::chrono::duration<double, std::milli> build = std::chrono::steady_clock::now() - build_start;
+    std::cout << table.Size() << " expressions, " << table.TermCount() << " terms; "
+              << "term index built in " << build.count() << " ms" << std::endl;
+    
+    // Requests define a prefix of the variables: every one of them, or a
+    // random number of them
+    std::mt19937 random(311);
+    for (bool full : {true, false}) {
+        std::vector<TruthAssignment> assignments;
+        for (std::size_t k = 0; k < n_assignments; ++k) {
+            std::size_t length = full ? 26 : random() % 27;
+            std::string values;
+            for (std::size_t j = 0; j < length; ++j) values += random() % 2 ? 'T' : 'F';
+            assignments.push_back(BuildAssignment(values));
+        }
+        
+        std::vector<ResultCounts> scanned(n_assignments), batched(n_assignments),
+                                  indexed(n_assignments);
+        std::cout << n_assignments << (full ? " full" : " random-length")
+                  << " assignments" << std::endl;
+        Time("scan", n_assignments, [&]() {
+            for (std::size_t k = 0; k < n_assignments; ++k)
+                scanned[k] = Scan(table, assignments[k]);
+        });
+        Time("batch", n_assignments, [&]() {
+            Batch(table, assignments, &batched);
+        });
+        Time("terms", n_assignments, [&]() {
+            for (std::size_t k = 0; k < n_assignments; ++k)
+                terms.Evaluate(assignments[k], &indexed[k]);
+        });
+        
+        for (std::size_t k = 0; k < n_assignments; ++k) {
+            if (!Same(scanned[k], batched[k]) || !Same(scanned[k], indexed[k])) {
+                std::cerr << "Results differ for assignment " << k << std::endl;
+                return 1;
+            }
+        }
+    }
+    
+    return 0;
+}
@@ -1,6 +1,12 @@
 #include <bool_expr_client.h>
 #include <domain_socket.h>
+#include <shared_memory_channel.h>
 #include <bool_expr_parser.h> 
+#include <bool_expr_protocol.h>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <iostream>
 #include <sstream>
 #include <csignal>
@@ -38,16 +44,43 @@ void signal_handler(int) {
 // BooleanExpressionClient class - extends DomainSocketClient
 class BooleanExpressionClient : public DomainSocketClient {
 private:
+    // Most requests sent ahead of their replies; bounded so neither side
+    // can fill the socket while the other waits to write
+    static const size_t kWindow = 64;
+
+    // Most sets of truth values sent in one batch request
+    static const size_t kBatchSize = 256;
+
     char eot_;
     char unit_separator_;
+    
+    // Carries requests and replies instead of the socket once the server
+    // has accepted it
+    SharedMemoryChannel channel_;
+    bool on_ring_ = false;
+    
+    // Expression file passed with every request, if any
+    int expressions_fd_ = -1;
+    
+    // Whether to use the binary protocol, whether the server's greeting
+    // offered it, and whether the connection has switched to it
+    bool want_binary_ = true;
+    bool binary_offered_ = false;
+    bool binary_ = false;
 
 public:
-    BooleanExpressionClient(const char* server_name, bool abstract) : DomainSocketClient(server_name, abstract), 
+    BooleanExpressionClient(const char* server_name, bool abstract, int type = SOCK_STREAM)
+        : DomainSocketClient(server_name, abstract, type), 
           eot_('.'),            // Default EOT
           unit_separator_(':')  // Default unit separator
     {}
 
-    bool ConnectAndProcess(const std::string& truth_values) {
+    // Sends every set of truth values over one connection. Requests are
+    // pipelined, up to kWindow at a time, and the server answers them in
+    // order, so each reply belongs to the oldest unanswered request. With
+    // batch set, up to kBatchSize sets share each request. With ring set,
+    // they travel through shared memory if the server agrees.
+    bool ConnectAndProcess(const std::vector<std::string>& requests, bool batch, bool ring = false) {
         // Connect to server
         std::cout << "BoolExprClient connecting..." << std::endl;
         
@@ -59,30 +92,243 @@ public:
         if (!ReceiveConfiguration()) {
             return false;
         }
-
-        // Send truth values and get response
-        std::string formatted_values = FormatTruthValues(truth_values);
-        ssize_t bytes_sent = Write(formatted_values, eot_);
-        if (bytes_sent <= 0) {
+        
+        if (ring && !StartRing()) {
+            std::cerr << "Shared memory refused; using the socket" << std::endl;
+        }
+        
+        // Expression files travel with text requests only
+        if (want_binary_ && binary_offered_ && expressions_fd_ < 0 && !StartBinary()) {
             return false;
         }
 
-        // Process server response
-        return ProcessResponse(bytes_sent);
+        std::vector<std::string> formatted_values;
+        for (size_t i = 0; i < requests.size(); ++i) {
+            if (binary_) {
+                // A batch request packs up to kBatchSize assignments
+                if (!batch || i % kBatchSize == 0) formatted_values.emplace_back();
+                AppendAssignment(PackTruthValues(requests[i]), &formatted_values.back());
+            } else if (!batch) {
+                formatted_values.push_back(FormatTruthValues(requests[i]));
+            } else if (i % kBatchSize == 0) {
+                formatted_values.push_back(kBatchMarker + FormatTruthValues(requests[i]));
+            } else {
+                formatted_values.back() += kBatchSeparator + FormatTruthValues(requests[i]);
+            }
+        }
+
+        size_t sent = 0, received = 0;
+        while (received < formatted_values.size() && keep_running) {
+            // Top the window back up once half of it has been answered
+            if (sent < formatted_values.size() && sent - received <= kWindow / 2) {
+                size_t end = std::min(formatted_values.size(), received + kWindow);
+                std::vector<std::string> batch(formatted_values.begin() + sent,
+                                               formatted_values.begin() + end);
+                if (!Send(batch)) {
+                    return false;
+                }
+                
+                // The echo of a switch to binary comes before the first reply
+                if (sent == 0 && binary_ && !FinishBinary()) {
+                    return false;
+                }
+                sent = end;
+            }
+
+            // Process server response
+            size_t framing = binary_ && !on_ring_ ? MessageReader::kFrameHeader : 1;
+            ssize_t bytes_sent = formatted_values[received].size() + framing;
+            if (!ProcessResponse(bytes_sent)) {
+                return false;
+            }
+            ++received;
+        }
+
+        if (on_ring_) channel_.Close();
+        return true;
+    }
+
+    // Has every request answered against the expressions in this file
+    // instead of the server's
+    void UseExpressions(int expressions_fd) {
+        expressions_fd_ = expressions_fd;
+    }
+
+    // Keeps to the text protocol even if the server offers binary
+    void UseText() {
+        want_binary_ = false;
+    }
+
+    // Sends every set of truth values as one batch in a memfd, which the
+    // server reads in place, and has the replies written to another
+    bool UploadAndProcess(const std::vector<std::string>& requests) {
+        std::cout << "BoolExprClient connecting..." << std::endl;
+        
+        if (!Init() || !ReceiveConfiguration()) {
+            return false;
+        }
+        
+        std::string batch;
+        for (const std::string& request : requests) {
+            if (!batch.empty()) batch += kBatchSeparator;
+            batch += FormatTruthValues(request);
+        }
+        
+        // The batch is sealed so the server can map it rather than copy it
+        int batch_fd = ::memfd_create("bool-expr-batch", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        int reply_fd = ::memfd_create("bool-expr-replies", MFD_CLOEXEC);
+        bool uploaded = batch_fd >= 0 && reply_fd >= 0
+                     && ::write(batch_fd, batch.data(), batch.size()) == static_cast<ssize_t>(batch.size())
+                     && ::fcntl(batch_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == 0;
+        
+        std::string reply;
+        uploaded = uploaded && Write(std::string(1, kUploadMarker), eot_, {batch_fd, reply_fd}) > 0
+                            && Read(eot_, &reply) > 0
+                            && reply.size() > 1 && reply[0] == kUploadMarker;
+        
+        // The reply on the socket is just the size of the replies in the file
+        size_t size = 0;
+        void* replies = MAP_FAILED;
+        if (uploaded) {
+            size = std::stoul(reply.substr(1));
+            replies = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, reply_fd, 0);
+        }
+        if (replies != MAP_FAILED) {
+            std::cout << "Finished with " << size + 1 << "B received, "
+                      << batch.size() + 1 << "B sent." << std::endl;
+            PrintResults(std::string(static_cast<const char*>(replies), size));
+            ::munmap(replies, size);
+        }
+        
+        if (batch_fd >= 0) ::close(batch_fd);
+        if (reply_fd >= 0) ::close(reply_fd);
+        return replies != MAP_FAILED;
     }
 
 private:
-    bool ReceiveConfiguration() {
-        std::string config;
-        ssize_t config_bytes = Read(eot_, &config);
+    // Passes the server a new shared memory channel; false if it declines
+    bool StartRing() {
+        if (!channel_.Create()) {
+            return false;
+        }
+        
+        std::string reply;
+        if (Write(std::string(1, kRingMarker), eot_, channel_.Descriptors()) <= 0
+            || Read(eot_, &reply) <= 0) {
+            return false;
+        }
         
-        if (config_bytes > 0 && config.length() >= 2) {
-            unit_separator_ = config[0];
-            eot_ = config[1];
+        on_ring_ = reply.size() == 1 && reply[0] == kRingMarker;
+        return on_ring_;
+    }
+
+    // Switches to the binary protocol the server offered. Requests follow
+    // without waiting for the server's echo, which FinishBinary reads.
+    bool StartBinary() {
+        if (!Send({{kBinaryMarker, kBinaryVersion}})) {
+            return false;
+        }
+        
+        binary_ = true;
+        return true;
+    }
+
+    // Reads the echo of the switch; replies after it are binary
+    bool FinishBinary() {
+        std::string reply;
+        if (Receive(&reply) <= 0 || reply != std::string{kBinaryMarker, kBinaryVersion}) {
+            return false;
+        }
+        
+        if (!on_ring_) UseFrames(true);
+        return true;
+    }
+
+    bool Send(const std::vector<std::string>& messages) {
+        if (expressions_fd_ >= 0) {
+            for (const std::string& message : messages) {
+                if (Write(kExpressionsMarker + message, eot_, {expressions_fd_}) <= 0) {
+                    return false;
+                }
+            }
             return true;
         }
         
-        return false;
+        if (!on_ring_) {
+            return (binary_ ? WriteFrames(messages) : Write(messages, eot_)) > 0;
+        }
+        
+        for (const std::string& message : messages) {
+            if (!channel_.Send(message)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Waits for the next reply, from wherever replies are coming; returns
+    // its size including eot as Read does
+    ssize_t Receive(std::string* reply) {
+        if (!on_ring_) {
+            return Read(eot_, reply);
+        }
+        
+        // Wake up now and then to notice a signal
+        const int kWaitMilliseconds = 500;
+        while (keep_running) {
+            int received = channel_.Receive(reply, kWaitMilliseconds);
+            if (received != 0) {
+                return received > 0 ? reply->size() + 1 : 0;
+            }
+        }
+        return -1;
+    }
+
+    bool ReceiveConfiguration() {
+        // The configuration is the unit separator and eot characters, then
+        // any protocol the server offers, then eot itself. The first two
+        // are read by length: scanning for an eot we do not know yet would
+        // stop at the eot inside the message.
+        const std::size_t kConfigBytes = 2;
+        std::string config, offer;
+        ssize_t config_bytes = Read(kConfigBytes, &config);
+        
+        if (config_bytes <= 0 || config.length() != kConfigBytes) {
+            return false;
+        }
+        
+        unit_separator_ = config[0];
+        eot_ = config[1];
+        if (Read(eot_, &offer) <= 0) {
+            return false;
+        }
+        
+        binary_offered_ = offer == std::string{kBinaryMarker, kBinaryVersion};
+        return true;
+    }
+
+    // Packs truth values into an assignment as FormatTruthValues reads them
+    TruthAssignment PackTruthValues(const std::string& truth_values) {
+        std::istringstream iss(truth_values);
+        std::string token;
+        TruthAssignment assignment = {0, 0};
+        
+        // Values past z are ignored, as the server does
+        for (int i = 0; i < 26 && iss >> token; ) {
+            if (token != "T" && token != "F") 
+                continue;
+            
+            assignment.defined |= uint32_t(1) << i;
+            if (token == "T") assignment.values |= uint32_t(1) << i;
+            ++i;
+        }
+        
+        // If no valid values found, use the same default
+        if (assignment.defined == 0) {
+            assignment.defined = 1;
+        }
+        
+        return assignment;
     }
 
     std::string FormatTruthValues(const std::string& truth_values) {
@@ -114,28 +360,48 @@ private:
 
     bool ProcessResponse(ssize_t bytes_sent) {
         std::string response;
-        ssize_t bytes_received = Read(eot_, &response);
+        ssize_t bytes_received = Receive(&response);
         
         if (bytes_received <= 0) {
             return false;
         }
 
-        // Parse response
-        int true_evaluations = 0;
-        int false_evaluations = 0;
-        int could_not_evaluate = 0;
+        std::cout << "Finished with " << bytes_received << "B received, " 
+                  << bytes_sent << "B sent." << std::endl;
+
+        PrintResults(response);
+        return true;
+    }
+
+    void PrintResults(const std::string& response) {
+        if (binary_) {
+            // Fixed-size counts, one group per assignment
+            for (size_t i = 0; i + kCountsBytes <= response.size(); i += kCountsBytes) {
+                PrintCounts(ReadCounts(response.data() + i));
+            }
+            return;
+        }
         
-        ParseResponse(response, true_evaluations, false_evaluations, could_not_evaluate);
+        // A batch reply holds one set of counts per set of truth values
+        std::istringstream replies(response);
+        std::string reply;
+        while (std::getline(replies, reply, kBatchSeparator)) {
+            // Parse response
+            int true_evaluations = 0;
+            int false_evaluations = 0;
+            int could_not_evaluate = 0;
+            
+            ParseResponse(reply, true_evaluations, false_evaluations, could_not_evaluate);
+            PrintCounts(ResultCounts{true_evaluations, false_evaluations, could_not_evaluate});
+        }
+    }
 
+    void PrintCounts(const ResultCounts& counts) {
         // Output results with nice formatting
-        std::cout << "Finished with " << bytes_received << "B received, " 
-                  << bytes_sent << "B sent." << std::endl;
         std::cout << "Results" << std::endl;
-        std::cout << "True Evaluations: " << true_evaluations << std::endl;
-        std::cout << "False Evaluations: " << false_evaluations << std::endl;
-        std::cout << "Could Not Evaluate: " << could_not_evaluate << std::endl;
-        
-        return true;
+        std::cout << "True Evaluations: " << counts.true_count << std::endl;
+        std::cout << "False Evaluations: " << counts.false_count << std::endl;
+        std::cout << "Could Not Evaluate: " << counts.error_count << std::endl;
     }
 
     void ParseResponse(const std::string& response, int& true_evaluations, int& false_evaluations, int& could_not_evaluate) {
@@ -176,7 +442,16 @@ private:
 int main(int argc, char* argv[]) {
     if (argc < 3) {
         std::cerr << "Usage: " << argv[0] << " <server_name> <truth_values>" << std::endl;
+        std::cerr << "       " << argv[0] << " <server_name> [--batch] [--ring | --upload] -" << std::endl;
+        std::cerr << "       " << argv[0] << " <server_name> [--seqpacket] [--text] [--expressions=<file>] ..." << std::endl;
         std::cerr << "Example: " << argv[0] << " bool_expr_sock T F T F F T" << std::endl;
+        std::cerr << "With -, each line of standard input is a set of truth values,"
+                  << " all sent over one connection; --batch sends many sets per request,"
+                  << " --ring sends requests through shared memory, and --upload passes"
+                  << " them all to the server as one file; --expressions has the server use"
+                  << " that file's expressions instead of its own; --seqpacket connects to"
+                  << " a server started with --seqpacket; --text keeps to the text protocol"
+                  << " rather than asking for the binary one" << std::endl;
         return 1;
     }
 
@@ -193,18 +468,83 @@ int main(int argc, char* argv[]) {
 
     std::string server_name = argv[1];
     
-    // Combine all remaining arguments into a single string for truth values
-    std::string truth_values;
-    for (int i = 2; i < argc; i++) {
-        truth_values += argv[i];
-        if (i < argc - 1) {
-            truth_values += " ";
+    // The socket type and an expression file may follow the server name
+    int first = 2;
+    int type = SOCK_STREAM;
+    bool text = false;
+    std::string expressions_path;
+    const std::string kExpressionsFlag = "--expressions=";
+    for (; first < argc; ++first) {
+        std::string flag = argv[first];
+        if (flag == "--seqpacket") {
+            type = SOCK_SEQPACKET;
+        } else if (flag == "--text") {
+            text = true;
+        } else if (flag.compare(0, kExpressionsFlag.size(), kExpressionsFlag) == 0) {
+            expressions_path = flag.substr(kExpressionsFlag.size());
+        } else {
+            break;
         }
     }
+    
+    // Other options come between it and a final -
+    bool from_stdin = first < argc && std::string(argv[argc - 1]) == "-";
+    bool batch = false, ring = false, upload = false;
+    for (int i = first; from_stdin && i < argc - 1; i++) {
+        std::string flag = argv[i];
+        if (flag == "--batch") {
+            batch = true;
+        } else if (flag == "--ring") {
+            ring = true;
+        } else if (flag == "--upload") {
+            upload = true;
+        } else {
+            from_stdin = false;
+        }
+    }
+    
+    // Each of these carries requests its own way
+    if ((ring && (upload || !expressions_path.empty())) || (upload && !expressions_path.empty())) {
+        std::cerr << "--ring, --upload and --expressions cannot be combined" << std::endl;
+        return 1;
+    }
+    
+    std::vector<std::string> requests;
+    if (from_stdin) {
+        // One request per line of standard input
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            if (!line.empty()) requests.push_back(line);
+        }
+    } else {
+        // Combine all remaining arguments into a single string for truth values
+        std::string truth_values;
+        for (int i = first; i < argc; i++) {
+            truth_values += argv[i];
+            if (i < argc - 1) {
+                truth_values += " ";
+            }
+        }
+        requests.push_back(truth_values);
+    }
 
     // Create and use client
-    BooleanExpressionClient client(server_name.c_str(), true);
-    client.ConnectAndProcess(truth_values);
+    BooleanExpressionClient client(server_name.c_str(), true, type);
+    if (text) client.UseText();
+    if (!expressions_path.empty()) {
+        int expressions_fd = ::open(expressions_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (expressions_fd < 0) {
+            std::cerr << "Unable to open file: " << expressions_path << std::endl;
+            return 1;
+        }
+        client.UseExpressions(expressions_fd);
+    }
+    
+    if (upload) {
+        client.UploadAndProcess(requests);
+    } else {
+        client.ConnectAndProcess(requests, batch, ring);
+    }
 
     return 0;
 }
\ No newline at end of file
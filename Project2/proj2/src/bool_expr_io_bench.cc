@@ -0,0 +1,144 @@
+// Times the server's event loops against each other on the same load:
+//
+//   epoll     DomainSocketServer::Serve
+//   io_uring  DomainSocketServer::ServeUring
+//
+// Each serves a fixed reply from a thread of this process, first to short
+// connections (connect, read the greeting, one request, close), then to
+// long ones that pipeline requests in windows. Client threads split the
+// work between them.
+//
+// Usage: bool-expr-io-bench [clients] [requests]
+//
+
+#include <domain_socket.h>
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char kUnitSeparator = ':';
+const char kEot = '\004';
+const std::size_t kWindow = 64;  // requests in flight per long connection
+
+// Answers every request with the same counts, so the loop is all that is
+// timed
+class FixedServer : public DomainSocketServer {
+public:
+    explicit FixedServer(const char* name)
+        : DomainSocketServer(name, kUnitSeparator, kEot) {}
+
+protected:
+    std::string Greeting() override {
+        return std::string(1, kUnitSeparator) + kEot;
+    }
+
+    std::string Respond(std::string_view) override {
+        return "12T:30F:0E";
+    }
+};
+
+// Connects, reads the greeting and sends one request, count times
+bool ShortConnections(const char* name, std::size_t count) {
+    std::string reply;
+    for (std::size_t i = 0; i < count; ++i) {
+        DomainSocketClient client(name);
+        if (!client.Init() || client.Read(kEot, &reply) <= 0
+            || client.Write("TFTF", kEot) <= 0 || client.Read(kEot, &reply) <= 0)
+            return false;
+    }
+    return true;
+}
+
+// Sends count requests on one connection, kWindow at a time
+bool LongConnection(const char* name, std::size_t count) {
+    DomainSocketClient client(name);
+    std::string reply;
+    if (!client.Init() || client.Read(kEot, &reply) <= 0)
+        return false;
+
+    for (std::size_t sent = 0; sent < count; sent += kWindow) {
+        std::size_t window = std::min(kWindow, count - sent);
+        if (client.Write(std::vector<std::string>(window, "TFTF"), kEot) <= 0)
+            return false;
+        for (std::size_t i = 0; i < window; ++i)
+            if (client.Read(kEot, &reply) <= 0)
+                return false;
+    }
+    return true;
+}
+
+// Runs work on n_clients threads against a fresh server on the chosen
+// loop, reporting operations per second
+template <typename Work>
+bool Time(const char* backend, const char* load, bool uring,
+          std::size_t n_clients, std::size_t n_operations, Work work) {
+    const char* name = "bool_expr_io_bench";
+    FixedServer server(name);
+    if (!server.Init(128))
+        return false;
+
+    volatile std::sig_atomic_t keep_running = 1;
+    std::thread loop([&] {
+        if (uring)
+            server.ServeUring(&keep_running);
+        else
+            server.Serve(&keep_running);
+    });
+
+    std::vector<char> ok(n_clients, 0);
+    std::vector<std::thread> clients;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t c = 0; c < n_clients; ++c) {
+        std::size_t share = n_operations / n_clients
+                            + (c < n_operations % n_clients ? 1 : 0);
+        clients.emplace_back([&, c, share] { ok[c] = work(name, share); });
+    }
+    for (std::thread& client : clients)
+        client.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    keep_running = 0;
+    loop.join();
+
+    for (char client_ok : ok) {
+        if (!client_ok) {
+            std::cerr << backend << " " << load << ": a client failed" << std::endl;
+            return false;
+        }
+    }
+    std::cout << "  " << backend << " " << load << ": "
+              << static_cast<std::size_t>(n_operations / elapsed.count())
+              << "/s" << std::endl;
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::size_t n_clients = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 8;
+    std::size_t n_requests = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20000;
+    if (n_clients == 0 || n_requests == 0) {
+        std::cerr << "Usage: " << argv[0] << " [clients] [requests]" << std::endl;
+        return 1;
+    }
+
+    // A client closing early must not end the server thread
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::cout << n_clients << " clients, " << n_requests << " requests" << std::endl;
+    for (bool uring : {false, true}) {
+        const char* backend = uring ? "io_uring" : "epoll";
+        if (!Time(backend, "connections", uring, n_clients, n_requests, ShortConnections)
+            || !Time(backend, "requests", uring, n_clients, n_requests, LongConnection))
+            return 1;
+    }
+
+    return 0;
+}
@@ -1,13 +1,30 @@
 #include <bool_expr_server.h>
 #include <domain_socket.h>
+#include <shared_memory_channel.h>
 #include <bool_expr_parser.h>
+#include <bool_expr_compiler.h>
+#include <bool_expr_table.h>
+#include <bool_expr_protocol.h>
+#include <evaluator_pool.h>
+#include <result_cache.h>
+#include <delta_evaluator.h>
+#include <term_index.h>
+#include <truth_table_index.h>
+#include <algorithm>
 #include <iostream>
-#include <fstream>
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <csignal>
+#include <cstdint>
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 // Global flag for clean shutdown
 volatile sig_atomic_t keep_running = 1;
@@ -18,98 +35,632 @@ void signal_handler(int signal_num) {
     keep_running = 0;
 }
 
+// A whole file, such as one a client passed; empty if it cannot be read.
+// A memfd sealed against shrinking and writing is mapped in place. Any
+// other file is copied, since a mapping of a file its owner can still
+// truncate would crash the server with SIGBUS.
+class FileContents {
+public:
+    explicit FileContents(int fd) : data_(nullptr), size_(0) {
+        struct stat sb;
+        if (::fstat(fd, &sb) < 0 || sb.st_size <= 0) return;
+        
+        const int kSeals = F_SEAL_SHRINK | F_SEAL_WRITE;
+        int seals = ::fcntl(fd, F_GET_SEALS);
+        if (seals < 0 || (seals & kSeals) != kSeals) {
+            Copy(fd, sb.st_size);
+            return;
+        }
+        
+        void* addr = ::mmap(nullptr, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) return;
+        data_ = addr;
+        size_ = sb.st_size;
+    }
+    
+    ~FileContents() {
+        if (data_) ::munmap(data_, size_);
+    }
+    
+    std::string_view Contents() const {
+        return data_ ? std::string_view(static_cast<const char*>(data_), size_) : copy_;
+    }
+
+private:
+    // Reads up to size bytes; a file that shrinks meanwhile is cut short
+    void Copy(int fd, std::size_t size) {
+        copy_.resize(size);
+        size_t copied = 0;
+        while (copied < size) {
+            ssize_t bytes = ::pread(fd, &copy_[copied], size - copied, copied);
+            if (bytes <= 0) break;
+            copied += bytes;
+        }
+        copy_.resize(copied);
+    }
+
+    void* data_;
+    std::size_t size_;
+    std::string copy_;
+    
+    // Non-copyable
+    FileContents(const FileContents&) = delete;
+    FileContents& operator=(const FileContents&) = delete;
+};
+
+// Compiles a text expression file into expressions, one per line, as the
+// server's own file or one a client passed
+void LoadExpressions(int fd, ExpressionTable* expressions) {
+    FileContents text(fd);
+    std::string_view contents = text.Contents();
+    while (!contents.empty()) {
+        size_t end = std::min(contents.find('\n'), contents.size());
+        std::string line(contents.substr(0, end));
+        contents.remove_prefix(std::min(end + 1, contents.size()));
+        
+        // Pre-process expressions using Explode for consistency
+        std::string exploded = Explode(line.c_str(), ' ');
+        if (!exploded.empty()) expressions->Append(CompiledExpression(exploded));
+    }
+}
+
 // BooleanExpressionServer class - extends DomainSocketServer
 class BooleanExpressionServer : public DomainSocketServer {
 private:
-    std::vector<std::string> expressions_;
+    const ExpressionTable& expressions_;
+    EvaluatorPool& pool_;
+    ResultCache& cache_;
+    const TruthTableIndex& index_;
+    const DeltaEvaluator* delta_;  // null unless delta evaluation is on
+    const TermIndex* terms_;  // null unless the term index is on
     char unit_separator_;
+    
+    // Each connected client's last assignment, for delta evaluation
+    std::unordered_map<int, DeltaState> states_;
+    
+    // A client's requests over shared memory, answered on its own thread
+    struct RingSession {
+        SharedMemoryChannel channel;
+        std::thread thread;
+    };
+    std::unordered_map<int, std::unique_ptr<RingSession>> rings_;
+    
+    // Descriptors each client has passed and not yet used, oldest first
+    std::unordered_map<int, std::vector<int>> descriptors_;
+    
+    // Clients that have switched to the binary protocol
+    std::unordered_set<int> binary_;
+    
+    // Guards the per-client maps above, which the socket loop and ring
+    // threads share. Requests are evaluated without it: the expressions
+    // and indexes are read-only, and the cache and pool lock themselves.
+    std::mutex mutex_;
+
+    // One shard's results, on its own cache line so threads never share one
+    struct alignas(64) Counts {
+        int true_count = 0;
+        int false_count = 0;
+        int error_count = 0;
+    };
+
+    // One shard's results for a batch
+    struct alignas(64) BatchCounts {
+        SlicedCounter true_counts;
+        SlicedCounter error_counts;
+    };
 
 public:
-    BooleanExpressionServer(const char* sock_path, bool abstract, char unit_separator, char eot, const std::vector<std::string>& expressions) 
-    : DomainSocketServer(sock_path, abstract, eot), expressions_(expressions), unit_separator_(unit_separator) {}
+    BooleanExpressionServer(const char* sock_path, bool abstract, char unit_separator, char eot, const ExpressionTable& expressions,
+                            EvaluatorPool& pool, ResultCache& cache, const TruthTableIndex& index,
+                            const DeltaEvaluator* delta, const TermIndex* terms, int type = SOCK_STREAM)
+    : DomainSocketServer(sock_path, unit_separator, eot, abstract, type), expressions_(expressions), pool_(pool), cache_(cache),
+      index_(index), delta_(delta), terms_(terms), unit_separator_(unit_separator) {}
+    
+    ~BooleanExpressionServer() {
+        while (!rings_.empty()) {
+            StopRing(rings_.begin()->first);
+        }
+        for (const auto& passed : descriptors_) {
+            for (int descriptor : passed.second) ::close(descriptor);
+        }
+    }
 
-    // Process a client connection
+    // Process a client connection, answering requests until it disconnects
     void HandleClient(int client_socket) {
         if (client_socket < 0) return;
         
+        // Send configuration
+        Write(client_socket, Greeting());
+        
+        // Read truth values
+        MessageReader reader;
+        std::string_view buffer;
+        while (keep_running && Read(client_socket, &reader, &buffer) > 0) {
+            std::vector<int> descriptors = reader.TakeDescriptors();
+            if (!descriptors.empty()) Received(client_socket, descriptors);
+            
+            // Answer this request and any others the client has already
+            // pipelined behind it, then send the replies together. Replies
+            // are framed as their requests were, so those to requests
+            // before a switch of framing are sent first.
+            std::vector<std::string> replies;
+            bool frames = reader.Frames();
+            bool written = true;
+            do {
+                replies.push_back(RespondTo(client_socket, buffer));
+                reader.UseFrames(UsesFrames(client_socket));
+                if (reader.Frames() != frames) {
+                    written = SendReplies(client_socket, replies, frames);
+                    replies.clear();
+                    frames = reader.Frames();
+                }
+            } while (written && reader.Next(eot_, &buffer));
+            
+            if (!written || !SendReplies(client_socket, replies, frames)) break;
+        }
+        
+        Disconnected(client_socket);
+        ::close(client_socket);
+    }
+
+protected:
+    // Configuration sent to each client as it connects, offering the
+    // binary protocol unless the eot would be mistaken for part of the offer
+    std::string Greeting() override {
         std::cout << "Client connected" << std::endl;
         
-        // Send configuration
         std::string config;
         config.push_back(unit_separator_);
         config.push_back(eot_);  // Access parent class eot_
-        Write(client_socket, config);
+        if (eot_ != kBinaryMarker && eot_ != kBinaryVersion) {
+            config.push_back(kBinaryMarker);
+            config.push_back(kBinaryVersion);
+        }
+        return config;
+    }
+
+    // Evaluates every expression with the client's truth values, or with
+    // each set of them in a batch request. A ring request moves the client
+    // onto the shared memory channel it passed.
+    std::string RespondTo(int client_fd, std::string_view buffer) override {
+        if (buffer.size() == 1 && buffer[0] == kRingMarker) {
+            return StartRing(client_fd);
+        }
         
-        // Read truth values
-        std::string buffer;
-        ssize_t bytes_received = Read(client_socket, &buffer);
+        return Answer(client_fd, buffer);
+    }
+
+    // Keeps a client's descriptors for the request they came with
+    void Received(int client_fd, const std::vector<int>& descriptors) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<int>& passed = descriptors_[client_fd];
+        passed.insert(passed.end(), descriptors.begin(), descriptors.end());
+    }
+
+    // Forgets a client's state and stops its ring once it has gone
+    void Disconnected(int client_fd) override {
+        StopRing(client_fd);
         
-        if (bytes_received > 0) {
-            // Use Explode to parse truth values with unit_separator_
-            std::string exploded_buffer = Explode(buffer.c_str(), unit_separator_);
-            std::string truth_values;
-            
-            // Extract only T and F
-            for (char c : exploded_buffer) {
-                if (c == 'T' || c == 'F') truth_values += c;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int descriptor : TakeDescriptors(client_fd)) ::close(descriptor);
+        descriptors_.erase(client_fd);
+        states_.erase(client_fd);
+        binary_.erase(client_fd);
+    }
+    
+    // Binary messages travel on the socket as frames
+    bool UsesFrames(int client_fd) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return binary_.count(client_fd) > 0;
+    }
+
+private:
+    // Builds the reply to one request
+    std::string Answer(int client_fd, std::string_view buffer) {
+        std::string response;
+        bool binary = UsesFrames(client_fd);
+        if (binary) {
+            response = RespondBinary(client_fd, buffer);
+        } else if (buffer.size() == 2 && buffer[0] == kBinaryMarker) {
+            // Switch to the binary protocol if this is the version offered.
+            // The echo is part of the handshake, not a reply worth logging.
+            if (buffer[1] == kBinaryVersion) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                binary_.insert(client_fd);
+                return std::string(buffer);
+            }
+        } else if (!buffer.empty() && buffer[0] == kBatchMarker) {
+            response = RespondBatch(buffer.substr(1));
+        } else if (!buffer.empty() && buffer[0] == kUploadMarker) {
+            response = RespondUpload(client_fd);
+        } else if (!buffer.empty() && buffer[0] == kExpressionsMarker) {
+            response = RespondWithExpressions(client_fd, buffer.substr(1));
+        } else {
+            ResultCache::Counts counts = CountAssignment(client_fd, BuildAssignment(TruthValues(buffer)));
+            response = FormatCounts(counts.true_count, counts.false_count, counts.error_count);
+        }
+        
+        // Both counts include the eot character, or the frame header
+        size_t framing = binary ? MessageReader::kFrameHeader : 1;
+        std::cout << "\t" << response.size() + framing << "B sent, " 
+                  << buffer.size() + framing << "B received" << std::endl;
+        
+        return response;
+    }
+
+    // Counts the results of one assignment
+    ResultCache::Counts CountAssignment(int client_fd, const TruthAssignment& assignment) {
+        uint64_t key = CacheKey(assignment);
+        
+        // Evaluate expressions, unless the index has the answer or this
+        // assignment was seen recently
+        ResultCache::Counts counts = {0, 0, 0};
+        bool indexed = assignment.defined != 0
+                    && index_.Lookup(expressions_.Generation(), assignment, &counts);
+        if (!indexed && !cache_.Lookup(key, expressions_.Generation(), &counts)) {
+            // Re-evaluate only what changed since the client's last
+            // assignment, or everything, keeping each result for next time.
+            // The client's state is taken out of states_ while in use; a
+            // request that finds it gone starts over from a full evaluation.
+            DeltaState taken;
+            DeltaState* state = delta_ && assignment.defined != 0 ? &taken : nullptr;
+            if (state) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::swap(taken, states_[client_fd]);
+            }
+            if (!state || !delta_->Update(assignment, state, &counts)) {
+                if (state) state->results.assign(expressions_.Size(), DeltaEvaluator::kError);
+                EvaluateExpressions(assignment, counts.true_count, counts.false_count, counts.error_count,
+                                    state ? state->results.data() : nullptr);
+                if (state && keep_running) delta_->Record(assignment, counts, state);
+            }
+            if (state) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::swap(taken, states_[client_fd]);
+            }
+            if (keep_running) cache_.Insert(key, expressions_.Generation(), counts);
+        }
+        return counts;
+    }
+
+    // Answers a binary request: packed assignments in, packed counts out.
+    // A request that is not whole assignments gets an empty reply.
+    std::string RespondBinary(int client_fd, std::string_view request) {
+        std::string response;
+        if (request.empty() || request.size() % kAssignmentBytes != 0) return response;
+        
+        std::vector<TruthAssignment> assignments(request.size() / kAssignmentBytes);
+        for (size_t i = 0; i < assignments.size(); ++i) {
+            assignments[i] = ReadAssignment(request.data() + i * kAssignmentBytes);
+        }
+        
+        response.reserve(assignments.size() * kCountsBytes);
+        if (assignments.size() == 1) {
+            AppendCounts(CountAssignment(client_fd, assignments[0]), &response);
+        } else {
+            for (const ResultCache::Counts& counts : CountBatch(assignments)) {
+                AppendCounts(counts, &response);
+            }
+        }
+        return response;
+    }
+
+    // Sends replies with eot_ after each, or as frames
+    bool SendReplies(int client_socket, const std::vector<std::string>& replies, bool frames) {
+        if (replies.empty()) return true;
+        return (frames ? WriteFrames(client_socket, replies) : Write(client_socket, replies)) >= 0;
+    }
+
+    // Maps the channel a client passed with its ring request and answers
+    // its requests from there on a thread of their own. The reply is
+    // kRingMarker, or empty if the channel is unusable.
+    std::string StartRing(int client_fd) {
+        std::vector<int> descriptors;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            descriptors = TakeDescriptors(client_fd);
+        }
+        
+        StopRing(client_fd);
+        std::unique_ptr<RingSession> session(new RingSession);
+        if (!session->channel.Attach(descriptors)) return std::string();
+        
+        RingSession* ring = session.get();
+        ring->thread = std::thread([this, client_fd, ring]() {
+            // Wake up now and then to notice shutdown, and give up on a
+            // client that leaves its ring full for long
+            const int kWaitMilliseconds = 500;
+            const int kSendMilliseconds = 5000;
+            std::string request;
+            while (keep_running) {
+                int received = ring->channel.Receive(&request, kWaitMilliseconds);
+                if (received < 0) break;
+                if (received == 0) continue;
+                
+                if (!ring->channel.Send(Answer(client_fd, request), kSendMilliseconds)) break;
+            }
+            ring->channel.Close();
+        });
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            rings_[client_fd] = std::move(session);
+        }
+        
+        std::cout << "Client moved to shared memory" << std::endl;
+        return std::string(1, kRingMarker);
+    }
+
+    // Removes up to count of the oldest descriptors a client has passed;
+    // the caller must close them. Needs mutex_.
+    std::vector<int> TakeDescriptors(int client_fd, size_t count = SIZE_MAX) {
+        std::vector<int> taken;
+        auto passed = descriptors_.find(client_fd);
+        if (passed == descriptors_.end()) return taken;
+        
+        std::vector<int>& pending = passed->second;
+        size_t n = std::min(count, pending.size());
+        taken.assign(pending.begin(), pending.begin() + n);
+        pending.erase(pending.begin(), pending.begin() + n);
+        return taken;
+    }
+
+    // Answers a batch the client passed as a file, reading it in place if
+    // the client sealed it.
+    // The reply goes back over the socket, or into a second file if the
+    // client passed one, leaving just its size for the socket.
+    std::string RespondUpload(int client_fd) {
+        std::vector<int> descriptors;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            descriptors = TakeDescriptors(client_fd);
+        }
+        if (descriptors.empty()) return std::string();
+        
+        std::string response;
+        {
+            FileContents batch(descriptors[0]);
+            response = RespondBatch(batch.Contents());
+        }
+        
+        if (descriptors.size() > 1) {
+            int reply_fd = descriptors[1];
+            size_t written = 0;
+            if (::ftruncate(reply_fd, 0) == 0) {
+                while (written < response.size()) {
+                    ssize_t bytes = ::pwrite(reply_fd, response.data() + written,
+                                             response.size() - written, written);
+                    if (bytes <= 0) break;
+                    written += bytes;
+                }
             }
+            response = kUploadMarker + std::to_string(written);
+        }
+        
+        for (int descriptor : descriptors) ::close(descriptor);
+        return response;
+    }
+
+    // Answers a request against the expressions in a file the client
+    // passed, a table from bool-expr-convert or text, instead of the
+    // server's own.
+    std::string RespondWithExpressions(int client_fd, std::string_view request) {
+        std::vector<int> descriptors;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            descriptors = TakeDescriptors(client_fd, 1);
+        }
+        if (descriptors.empty()) return std::string();
+        
+        ExpressionTable expressions;
+        if (!expressions.Load(descriptors[0], "uploaded expressions")) {
+            LoadExpressions(descriptors[0], &expressions);
+        }
+        ::close(descriptors[0]);
+        
+        // Each set of truth values is counted with a plain pass over the
+        // expressions; none of the server's indexes or caches apply
+        bool batch = !request.empty() && request[0] == kBatchMarker;
+        if (batch) request.remove_prefix(1);
+        std::string response;
+        for (;;) {
+            size_t end = batch ? request.find(kBatchSeparator) : std::string_view::npos;
+            std::string truth_values = TruthValues(request.substr(0, end));
+            ResultCounts counts = {0, 0, static_cast<int>(expressions.Size())};
+            if (!truth_values.empty()) counts = Count(expressions, BuildAssignment(truth_values));
             
-            // Evaluate expressions
-            int true_count = 0, false_count = 0, error_count = 0;
-            EvaluateExpressions(truth_values, true_count, false_count, error_count);
+            if (!response.empty()) response += kBatchSeparator;
+            response += FormatCounts(counts.true_count, counts.false_count, counts.error_count);
+            if (end == std::string_view::npos) break;
+            request.remove_prefix(end + 1);
+        }
+        return response;
+    }
+
+    // Evaluates each expression of a table in turn
+    static ResultCounts Count(const ExpressionTable& expressions, const TruthAssignment& assignment) {
+        ResultCounts counts = {0, 0, 0};
+        for (size_t i = 0; i < expressions.Size(); ++i) {
+            bool error = false;
+            bool result = expressions.Evaluate(i, assignment, &error);
+            if (error) {
+                counts.error_count++;
+            } else if (result) {
+                counts.true_count++;
+            } else {
+                counts.false_count++;
+            }
+        }
+        return counts;
+    }
+
+    // Closes a client's channel, if it has one, and waits for its thread.
+    // The thread may still need mutex_, so it is joined without it.
+    void StopRing(int client_fd) {
+        std::unique_ptr<RingSession> session;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto found = rings_.find(client_fd);
+            if (found == rings_.end()) return;
+            session = std::move(found->second);
+            rings_.erase(found);
+        }
+        
+        session->channel.Close();
+        session->thread.join();
+    }
+    // Extract only T and F, skipping unit separators; the same result as
+    // Explode, without copying the message first
+    std::string TruthValues(std::string_view buffer) const {
+        std::string truth_values;
+        for (char c : buffer) {
+            if (c != unit_separator_ && (c == 'T' || c == 'F')) truth_values += c;
+        }
+        return truth_values;
+    }
+
+    std::string FormatCounts(int true_count, int false_count, int error_count) const {
+        return std::to_string(true_count) + "T" + unit_separator_ +
+               std::to_string(false_count) + "F" + unit_separator_ +
+               std::to_string(error_count) + "E";
+    }
+
+    // Packs an assignment into a result cache key
+    static uint64_t CacheKey(const TruthAssignment& assignment) {
+        return uint64_t(assignment.defined) << 32 | assignment.values;
+    }
+
+    // Answers each set of truth values in a batch
+    std::string RespondBatch(std::string_view batch_buffer) {
+        std::vector<TruthAssignment> assignments;
+        for (;;) {
+            size_t end = batch_buffer.find(kBatchSeparator);
+            assignments.push_back(BuildAssignment(TruthValues(batch_buffer.substr(0, end))));
+            if (end == std::string_view::npos) break;
+            batch_buffer.remove_prefix(end + 1);
+        }
+        
+        std::string response;
+        for (const ResultCache::Counts& counts : CountBatch(assignments)) {
+            if (!response.empty()) response += kBatchSeparator;
+            response += FormatCounts(counts.true_count, counts.false_count, counts.error_count);
+        }
+        return response;
+    }
+
+    // Counts the results of each assignment in a batch. Those found in the
+    // index or the cache are answered from them; the rest are evaluated up
+    // to 64 per pass over the expressions.
+    std::vector<ResultCache::Counts> CountBatch(const std::vector<TruthAssignment>& assignments) {
+        const uint64_t generation = expressions_.Generation();
+        std::vector<ResultCache::Counts> results(assignments.size());
+        std::vector<size_t> pending;
+        for (size_t i = 0; i < assignments.size(); ++i) {
+            if (!index_.Lookup(generation, assignments[i], &results[i])
+                && !cache_.Lookup(CacheKey(assignments[i]), generation, &results[i])) {
+                pending.push_back(i);
+            }
+        }
+        
+        for (size_t first = 0; first < pending.size(); first += AssignmentBatch::kMaxSize) {
+            size_t last = std::min(pending.size(), first + AssignmentBatch::kMaxSize);
+            AssignmentBatch batch;
+            for (size_t p = first; p < last; ++p) {
+                batch.Add(assignments[pending[p]]);
+            }
             
-            // Send response
-            std::string response = std::to_string(true_count) + "T" + unit_separator_ +
-                                  std::to_string(false_count) + "F" + unit_separator_ +
-                                  std::to_string(error_count) + "E";
-                                  
-            ssize_t bytes_sent = Write(client_socket, response);
+            int true_counts[AssignmentBatch::kMaxSize];
+            int error_counts[AssignmentBatch::kMaxSize];
+            EvaluateBatch(batch, true_counts, error_counts);
             
-            if (bytes_sent > 0) {
-                std::cout << "\t" << bytes_sent << "B sent, " 
-                          << bytes_received << "B received" << std::endl;
+            for (size_t k = 0; k < batch.size; ++k) {
+                size_t i = pending[first + k];
+                int false_count = expressions_.Size() - true_counts[k] - error_counts[k];
+                results[i] = ResultCache::Counts{true_counts[k], false_count, error_counts[k]};
+                if (keep_running) cache_.Insert(CacheKey(assignments[i]), generation, results[i]);
             }
         }
+        return results;
+    }
+
+    // Counts, for each assignment of the batch, the expressions it makes true
+    // and those it cannot evaluate, visiting each expression once
+    void EvaluateBatch(const AssignmentBatch& batch, int true_counts[], int error_counts[]) {
+        std::vector<BatchCounts> shards(pool_.Size());
+        pool_.Run(expressions_.Size(),
+                  [&](size_t begin, size_t end, size_t shard) {
+            BatchCounts& counts = shards[shard];
+            for (size_t i = begin; i < end; ++i) {
+                if (!keep_running) break;
+                
+                uint64_t errors;
+                counts.true_counts.Add(expressions_.Evaluate(i, batch, &errors));
+                counts.error_counts.Add(errors);
+            }
+        });
         
-        ::close(client_socket);
+        for (size_t k = 0; k < batch.size; ++k) {
+            true_counts[k] = error_counts[k] = 0;
+            for (const BatchCounts& counts : shards) {
+                true_counts[k] += counts.true_counts.Count(k);
+                error_counts[k] += counts.error_counts.Count(k);
+            }
+        }
     }
 
-private:
-    // Evaluate all expressions with given truth values
-    void EvaluateExpressions(const std::string& truth_values, int& true_count, int& false_count, int& error_count) {
-        if (!truth_values.empty()) {
+    // Evaluate all expressions with given truth values, storing each one's
+    // DeltaEvaluator::Result in results unless it is null
+    void EvaluateExpressions(const TruthAssignment& assignment, int& true_count, int& false_count, int& error_count,
+                             uint8_t* results = nullptr) {
+        if (assignment.defined != 0) {
             try {
-                // Build the truth value map
-                std::unordered_map<char, bool> values_map = BuildMap(truth_values);
+                // Unless every result is wanted, visit only the terms that hold
+                ResultCounts counts;
+                if (terms_ && !results && terms_->Evaluate(assignment, &counts)) {
+                    true_count = counts.true_count;
+                    false_count = counts.false_count;
+                    error_count = counts.error_count;
+                    return;
+                }
                 
-                // Process each expression
-                for (const auto& expr_text : expressions_) {
-                    if (!keep_running) break;
-                    
-                    try {
-                        if (expr_text.empty()) continue;
-                        
-                        // Parse and evaluate the expression
-                        BooleanExpressionParser parser(expr_text, values_map);
-                        bool result = parser.Parse();
+                // Each pool thread counts its own range of expressions
+                std::vector<Counts> shards(pool_.Size());
+                pool_.Run(expressions_.Size(),
+                          [&](size_t begin, size_t end, size_t shard) {
+                    Counts& counts = shards[shard];
+                    for (size_t i = begin; i < end; ++i) {
+                        if (!keep_running) break;
                         
-                        // Count results
-                        if (parser.HasError()) {
-                            error_count++;
-                        } else if (result) {
-                            true_count++;
-                        } else {
-                            false_count++;
+                        try {
+                            // Check the expression's product terms directly
+                            bool error = false;
+                            bool result = expressions_.Evaluate(i, assignment, &error);
+                            
+                            // Count results
+                            if (error) {
+                                counts.error_count++;
+                            } else if (result) {
+                                counts.true_count++;
+                                if (results) results[i] = DeltaEvaluator::kTrue;
+                            } else {
+                                counts.false_count++;
+                                if (results) results[i] = DeltaEvaluator::kFalse;
+                            }
+                        } catch (...) {
+                            counts.error_count++;
                         }
-                    } catch (...) {
-                        error_count++;
                     }
+                });
+                
+                for (const Counts& counts : shards) {
+                    true_count += counts.true_count;
+                    false_count += counts.false_count;
+                    error_count += counts.error_count;
                 }
             } catch (...) {
-                error_count = expressions_.size();
+                error_count = expressions_.Size();
             }
         } else {
-            error_count = expressions_.size();
+            error_count = expressions_.Size();
         }
     }
 };
@@ -122,7 +673,8 @@ void cleanup_socket_file(const std::string& socket_path) {
 }
 
 // Run the server
-int start_server(const std::string& file_path, const std::string& server_name, char unit_separator, char eot) {
+int start_server(const std::string& file_path, const std::string& server_name, char unit_separator, char eot,
+                 const ServerOptions& options) {
     // Set up signal handlers
     struct sigaction sa;
     sa.sa_handler = signal_handler;
@@ -132,23 +684,54 @@ int start_server(const std::string& file_path, const std::string& server_name, c
     sigaction(SIGTERM, &sa, NULL);
     signal(SIGPIPE, SIG_IGN);
     
-    // Load expressions from file
-    std::vector<std::string> expressions;
-    std::ifstream file(file_path);
-    if (file.is_open()) {
-        std::string line;
-        while (std::getline(file, line)) {
-            if (!line.empty()) {
-                // Pre-process expressions using Explode for consistency
-                std::string exploded = Explode(line.c_str(), ' ');
-                if (!exploded.empty()) expressions.push_back(exploded);
-            }
-        }
-        file.close();
-    } else {
+    // Load expressions from file. A table written by bool-expr-convert is
+    // mapped as is; a text file is compiled into a table once up front.
+    // The server's own file is trusted not to shrink under the mapping.
+    ExpressionTable expressions;
+    int file = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) {
         std::cerr << "Unable to open file: " << file_path << std::endl;
         return 1;
     }
+    bool loaded = true;
+    if (ExpressionTable::IsBinary(file_path)) {
+        loaded = expressions.Load(file_path);
+        if (!loaded) std::cerr << expressions.Error() << std::endl;
+    } else {
+        LoadExpressions(file, &expressions);
+    }
+    ::close(file);
+    if (!loaded) return 1;
+
+    // Evaluator threads and cached results live as long as the server
+    EvaluatorPool pool(options.threads);
+    ResultCache cache(options.cache_size);
+    
+    // Precompute every answer if the expressions allow it, reusing a saved
+    // index when it still matches them
+    TruthTableIndex index;
+    if (options.index) {
+        if (!options.index_path.empty() && index.Load(options.index_path, expressions)) {
+            std::cout << "Loaded truth table index of " << index.Variables()
+                      << " variables" << std::endl;
+        } else if (index.Build(expressions, pool)) {
+            std::cout << "Built truth table index of " << index.Variables()
+                      << " variables" << std::endl;
+            if (!options.index_path.empty() && !index.Save(options.index_path)) {
+                std::cerr << index.Error() << std::endl;
+            }
+        } else {
+            std::cerr << "No truth table index: " << index.Error() << std::endl;
+        }
+    }
+
+    // Inverted index for answering clients' small changes incrementally
+    std::unique_ptr<DeltaEvaluator> delta;
+    if (options.delta) delta.reset(new DeltaEvaluator(expressions));
+    
+    // Terms grouped by their variables, for evaluating only those that hold
+    std::unique_ptr<TermIndex> terms;
+    if (options.term_index) terms.reset(new TermIndex(expressions));
 
     // Main server loop
     while (keep_running) {
@@ -157,13 +740,23 @@ int start_server(const std::string& file_path, const std::string& server_name, c
         try {
             // Create server with our custom class
             BooleanExpressionServer server(server_name.c_str(), true, 
-                                          unit_separator, eot, expressions);
+                                          unit_separator, eot, expressions, pool, cache, index,
+                                          delta.get(), terms.get(),
+                                          options.packets ? SOCK_SEQPACKET : SOCK_STREAM);
             
             if (!server.Init(5)) {
                 sleep(1);
                 continue;
             }
 
+            // Multiplex every client on this thread until signalled
+            if (options.event_loop) {
+                bool served = options.io_uring ? server.ServeUring(&keep_running)
+                                               : server.Serve(&keep_running);
+                if (!served) sleep(1);
+                continue;
+            }
+
             // Handle client connections
             while (keep_running) {
                 int client_socket = server.Accept();
@@ -183,13 +776,64 @@ int start_server(const std::string& file_path, const std::string& server_name, c
         cleanup_socket_file(server_name);
     }
     
+    if (options.cache_size > 0) {
+        std::cout << "Result cache: " << cache.Hits() << " hits, "
+                  << cache.Misses() << " misses" << std::endl;
+    }
+    
     return 0;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 5) {
+    ServerOptions options;
+    bool valid = argc >= 5;
+    for (int i = 5; valid && i < argc; ++i) {
+        std::string flag = argv[i];
+        if (flag == "--epoll") {
+            options.event_loop = true;
+        } else if (flag == "--io-uring") {
+            options.event_loop = true;
+            options.io_uring = true;
+        } else if (flag == "--term-index") {
+            options.term_index = true;
+        } else if (flag == "--delta") {
+            options.delta = true;
+        } else if (flag == "--seqpacket") {
+            options.packets = true;
+        } else if (flag == "--index") {
+            options.index = true;
+        } else if (flag.compare(0, 8, "--index=") == 0) {
+            options.index = true;
+            options.index_path = flag.substr(8);
+            valid = !options.index_path.empty();
+        } else if (flag == "--cache") {
+            options.cache_size = ServerOptions::kDefaultCacheSize;
+        } else if (flag.compare(0, 8, "--cache=") == 0) {
+            try {
+                int cache_size = std::stoi(flag.substr(8));
+                valid = cache_size >= 0;
+                options.cache_size = cache_size;
+            } catch (...) {
+                valid = false;
+            }
+        } else if (flag.compare(0, 10, "--threads=") == 0) {
+            try {
+                int threads = std::stoi(flag.substr(10));
+                valid = threads > 0;
+                options.threads = threads;
+            } catch (...) {
+                valid = false;
+            }
+        } else {
+            valid = false;
+        }
+    }
+
+    if (!valid) {
         std::cerr << "Usage: " << argv[0] << " <file_path> <server_name> "
-                  << "<unit_separator> <eot>" << std::endl;
+                  << "<unit_separator> <eot> [--epoll | --io-uring] [--threads=N] [--cache[=N]] "
+                  << "[--index[=path]] [--delta] "
+                  << "[--term-index] [--seqpacket]" << std::endl;
         return 1;
     }
 
@@ -198,5 +842,5 @@ int main(int argc, char* argv[]) {
     char unit_separator = argv[3][0];
     char eot = argv[4][0];
 
-    return start_server(file_path, server_name, unit_separator, eot);
+    return start_server(file_path, server_name, unit_separator, eot, options);
 }
\ No newline at end of file
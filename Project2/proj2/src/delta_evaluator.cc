@@ -0,0 +1,87 @@
+#include <delta_evaluator.h>
+
+DeltaEvaluator::DeltaEvaluator(const ExpressionTable& table)
+    : table_(table), generation_(table.Generation()), offsets_(27, 0),
+      variables_(table.Size(), 0) {
+    // Count each variable's users, then place them (a counting sort), so
+    // every list is in expression order
+    for (std::size_t i = 0; i < table_.Size(); ++i) {
+        if (table_.HasError(i)) continue;
+        variables_[i] = table_.Variables(i);
+        for (std::uint32_t variables = variables_[i]; variables; variables &= variables - 1) {
+            ++offsets_[__builtin_ctz(variables) + 1];
+        }
+    }
+    for (std::size_t j = 0; j < 26; ++j) {
+        offsets_[j + 1] += offsets_[j];
+    }
+
+    users_.resize(offsets_[26]);
+    std::vector<std::uint32_t> next(offsets_.begin(), offsets_.end() - 1);
+    for (std::size_t i = 0; i < table_.Size(); ++i) {
+        for (std::uint32_t variables = variables_[i]; variables; variables &= variables - 1) {
+            users_[next[__builtin_ctz(variables)]++] = i;
+        }
+    }
+}
+
+
+bool DeltaEvaluator::Update(const TruthAssignment& assignment, DeltaState* state,
+                            ResultCounts* counts) const {
+    if (!state->valid || state->generation != generation_
+        || table_.Generation() != generation_) {
+        return false;
+    }
+
+    // A variable matters if it became defined or undefined, or kept a
+    // definition but flipped
+    const TruthAssignment& last = state->assignment;
+    std::uint32_t changed = (last.defined ^ assignment.defined)
+                          | ((last.values ^ assignment.values) & last.defined & assignment.defined);
+
+    // Past a quarter of the expressions, the bookkeeping costs more than
+    // the full evaluation it saves
+    std::size_t affected = 0;
+    for (std::uint32_t bits = changed; bits; bits &= bits - 1) {
+        std::size_t j = __builtin_ctz(bits);
+        affected += offsets_[j + 1] - offsets_[j];
+    }
+    if (affected > table_.Size() / 4) return false;
+
+    // An expression using several changed variables is in several lists;
+    // it is evaluated only from the list of the first
+    ResultCounts& totals = state->counts;
+    int* by_result[3] = {&totals.false_count, &totals.true_count, &totals.error_count};
+    for (std::uint32_t bits = changed; bits; bits &= bits - 1) {
+        std::size_t j = __builtin_ctz(bits);
+        std::uint32_t earlier = changed & ((std::uint32_t(1) << j) - 1);
+        for (std::size_t k = offsets_[j]; k < offsets_[j + 1]; ++k) {
+            std::uint32_t i = users_[k];
+            if (variables_[i] & earlier) continue;
+
+            bool error = false;
+            bool value = table_.Evaluate(i, assignment, &error);
+            std::uint8_t result = error ? kError : value ? kTrue : kFalse;
+
+            std::uint8_t& previous = state->results[i];
+            if (result != previous) {
+                --*by_result[previous];
+                ++*by_result[result];
+                previous = result;
+            }
+        }
+    }
+
+    state->assignment = assignment;
+    *counts = totals;
+    return true;
+}
+
+
+void DeltaEvaluator::Record(const TruthAssignment& assignment, const ResultCounts& counts,
+                            DeltaState* state) const {
+    state->valid = true;
+    state->generation = generation_;
+    state->assignment = assignment;
+    state->counts = counts;
+}
@@ -0,0 +1,76 @@
+#include <evaluator_pool.h>
+
+EvaluatorPool::EvaluatorPool(std::size_t n_threads)
+    : task_(nullptr), n_(0), generation_(0), pending_(0), stopping_(false) {
+    for (std::size_t shard = 1; shard < n_threads; ++shard) {
+        workers_.emplace_back(&EvaluatorPool::Work, this, shard);
+    }
+}
+
+
+EvaluatorPool::~EvaluatorPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    start_.notify_all();
+
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+
+void EvaluatorPool::Run(std::size_t n, const Task& task, std::size_t min_shard) {
+    // A caller that finds the workers busy does its own work rather than
+    // queue behind another job
+    std::unique_lock<std::mutex> running(running_, std::defer_lock);
+    if (workers_.empty() || n < min_shard * Size() || !running.try_lock()) {
+        task(0, n, 0);
+        return;
+    }
+
+    // Publish the job and wake every worker
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        n_ = n;
+        pending_ = workers_.size();
+        ++generation_;
+    }
+    start_.notify_all();
+
+    // The caller takes the first shard
+    task(0, n / Size(), 0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return pending_ == 0; });
+    task_ = nullptr;
+}
+
+
+void EvaluatorPool::Work(std::size_t shard) {
+    std::size_t seen = 0;
+    for (;;) {
+        const Task* task;
+        std::size_t n;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+            if (stopping_) return;
+            seen = generation_;
+            task = task_;
+            n = n_;
+        }
+
+        // Shard boundaries must match the caller's first shard exactly
+        (*task)(n * shard / Size(), n * (shard + 1) / Size(), shard);
+
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            last = --pending_ == 0;
+        }
+        if (last) done_.notify_one();
+    }
+}
@@ -0,0 +1,70 @@
+#include <result_cache.h>
+
+ResultCache::ResultCache(std::size_t capacity)
+    : capacity_(capacity), hand_(0), generation_(0), hits_(0), misses_(0) {
+    slots_.reserve(capacity_);
+    index_.reserve(capacity_);
+}
+
+
+bool ResultCache::Lookup(std::uint64_t key, std::uint64_t generation, Counts* counts) {
+    if (capacity_ > 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Synchronize(generation);
+
+        auto found = index_.find(key);
+        if (found != index_.end()) {
+            Slot& slot = slots_[found->second];
+            slot.referenced = true;
+            *counts = slot.counts;
+            ++hits_;
+            return true;
+        }
+    }
+
+    ++misses_;
+    return false;
+}
+
+
+void ResultCache::Insert(std::uint64_t key, std::uint64_t generation, const Counts& counts) {
+    if (capacity_ == 0) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Synchronize(generation);
+
+    auto found = index_.find(key);
+    if (found != index_.end()) {
+        slots_[found->second].counts = counts;
+        return;
+    }
+
+    // Fill empty slots first
+    if (slots_.size() < capacity_) {
+        index_.emplace(key, slots_.size());
+        slots_.push_back(Slot{key, counts, false});
+        return;
+    }
+
+    // Sweep for an entry not hit since the hand last passed it
+    while (slots_[hand_].referenced) {
+        slots_[hand_].referenced = false;
+        hand_ = (hand_ + 1) % capacity_;
+    }
+
+    Slot& victim = slots_[hand_];
+    index_.erase(victim.key);
+    index_.emplace(key, hand_);
+    victim = Slot{key, counts, false};
+    hand_ = (hand_ + 1) % capacity_;
+}
+
+
+void ResultCache::Synchronize(std::uint64_t generation) {
+    if (generation == generation_) return;
+
+    slots_.clear();
+    index_.clear();
+    hand_ = 0;
+    generation_ = generation;
+}
@@ -0,0 +1,101 @@
+#include <term_index.h>
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+TermIndex::TermIndex(const ExpressionTable& table)
+    : table_(table), generation_(table.Generation()), variables_(table.Size(), 0),
+      n_errors_(0) {
+    std::vector<std::pair<std::uint32_t, Entry>> terms;  // by mask
+    std::map<std::uint32_t, std::size_t> usages;
+    for (std::size_t i = 0; i < table_.Size(); ++i) {
+        if (table_.HasError(i)) {
+            ++n_errors_;
+            continue;
+        }
+
+        variables_[i] = table_.Variables(i);
+        ++usages[variables_[i]];
+        for (const ExpressionTable::Term* term = table_.TermsBegin(i);
+             term != table_.TermsEnd(i); ++term) {
+            // A term with both x and x' never holds
+            if (term->positive & term->negative) continue;
+            terms.push_back({term->positive | term->negative,
+                             Entry{term->positive, static_cast<std::uint32_t>(i)}});
+        }
+    }
+
+    std::sort(terms.begin(), terms.end(), [](const auto& a, const auto& b) {
+        return std::tie(a.first, a.second.positive, a.second.expression)
+             < std::tie(b.first, b.second.positive, b.second.expression);
+    });
+
+    entries_.reserve(terms.size());
+    for (std::size_t k = 0; k < terms.size(); ++k) {
+        if (k == 0 || terms[k].first != terms[k - 1].first) {
+            groups_.push_back(Group{terms[k].first, k, k});
+        }
+        ++groups_.back().end;
+        entries_.push_back(terms[k].second);
+    }
+
+    for (const auto& usage : usages) {
+        usages_.push_back(Usage{usage.first, usage.second});
+    }
+}
+
+
+bool TermIndex::Evaluate(const TruthAssignment& assignment, ResultCounts* counts) const {
+    if (table_.Generation() != generation_) return false;
+
+    const std::uint32_t undefined = ~assignment.defined;
+
+    int error_count = n_errors_;
+    for (const Usage& usage : usages_) {
+        if (usage.mask & undefined) error_count += usage.count;
+    }
+
+    // Expressions already counted true, a bit each. The bitmap is kept per
+    // thread and left all clear after each call, by clearing only the
+    // words this call set, so no request allocates or wipes it.
+    thread_local std::vector<std::uint64_t> seen_words;
+    thread_local std::vector<std::uint32_t> touched_words;
+    const std::size_t n_words = (table_.Size() + 63) / 64;
+    if (seen_words.size() < n_words) {
+        seen_words.resize(n_words, 0);
+        touched_words.resize(n_words);
+    }
+    std::uint64_t* seen = seen_words.data();
+    std::uint32_t* touched = touched_words.data();
+    std::size_t n_touched = 0;
+
+    // A term using an undefined variable belongs to an expression that is
+    // an error anyway, so only groups within the defined variables are
+    // searched
+    int true_count = 0;
+    for (const Group& group : groups_) {
+        if (group.mask & undefined) continue;
+
+        const std::uint32_t key = assignment.values & group.mask;
+        auto first = std::lower_bound(
+            entries_.begin() + group.begin, entries_.begin() + group.end, key,
+            [](const Entry& entry, std::uint32_t positive) { return entry.positive < positive; });
+        for (auto entry = first; entry != entries_.begin() + group.end
+                                 && entry->positive == key; ++entry) {
+            std::uint32_t i = entry->expression;
+            std::uint64_t bit = std::uint64_t(1) << (i % 64);
+            if ((variables_[i] & undefined) || (seen[i / 64] & bit)) continue;
+
+            if (seen[i / 64] == 0) touched[n_touched++] = i / 64;
+            seen[i / 64] |= bit;
+            ++true_count;
+        }
+    }
+    for (std::size_t k = 0; k < n_touched; ++k) seen[touched[k]] = 0;
+
+    counts->true_count = true_count;
+    counts->error_count = error_count;
+    counts->false_count = table_.Size() - true_count - error_count;
+    return true;
+}
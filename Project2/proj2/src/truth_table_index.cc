@@ -0,0 +1,280 @@
+#include <truth_table_index.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+const char kMagic[4] = {'B', 'X', 'P', 'I'};
+
+struct FileHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t n_variables;
+    std::uint32_t n_expressions;
+    std::uint64_t fingerprint;
+};
+
+
+// Values of a through f in the 64 consecutive assignments of a block:
+// bit k of kLanePatterns[j] is bit j of k
+const std::uint64_t kLanePatterns[6] = {
+    0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+    0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull,
+};
+
+
+// Counts stored for an index of n variables
+std::size_t TrueCountsSize(std::size_t n_variables) {
+    return (std::size_t(2) << n_variables) - 1;
+}
+
+
+}  // namespace
+
+
+TruthTableIndex::TruthTableIndex()
+    : mapping_(nullptr), mapping_size_(0), valid_(false), generation_(0),
+      fingerprint_(0), n_variables_(0), n_expressions_(0),
+      error_counts_(nullptr), true_counts_(nullptr), err_msg_("") {
+}
+
+
+TruthTableIndex::~TruthTableIndex() {
+    Clear();
+}
+
+
+void TruthTableIndex::Clear() {
+    if (mapping_) munmap(mapping_, mapping_size_);
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+
+    owned_error_counts_.clear();
+    owned_true_counts_.clear();
+    valid_ = false;
+    n_variables_ = n_expressions_ = 0;
+    error_counts_ = true_counts_ = nullptr;
+}
+
+
+bool TruthTableIndex::Build(const ExpressionTable& table, EvaluatorPool& pool,
+                            std::size_t max_variables) {
+    Clear();
+
+    // Group expressions by width, the number of variables up to the last
+    // one they use; one of width m depends only on the first m values
+    std::vector<std::vector<std::size_t>> by_width(27);
+    std::size_t errors = 0, n = 0;
+    for (std::size_t i = 0; i < table.Size(); ++i) {
+        if (table.HasError(i)) {
+            ++errors;
+            continue;
+        }
+        std::uint32_t variables = table.Variables(i);
+        std::size_t width = variables ? 32 - __builtin_clz(variables) : 0;
+        by_width[width].push_back(i);
+        n = std::max(n, width);
+    }
+
+    if (n > max_variables) {
+        err_msg_ = "Expressions use " + std::to_string(n) + " variables, more than "
+                 + std::to_string(max_variables) + " can be indexed";
+        return false;
+    }
+
+    // With a prefix of length L defined, exactly the expressions wider than
+    // L (and those that did not compile) cannot be evaluated
+    owned_error_counts_.assign(n + 1, 0);
+    std::size_t wider = table.Size() - errors;
+    for (std::size_t length = 0; length <= n; ++length) {
+        wider -= by_width[length].size();
+        owned_error_counts_[length] = errors + wider;
+    }
+
+    // Level m counts the expressions no wider than m that each of its 2^m
+    // assignments makes true: level m - 1's count for the same first m - 1
+    // values, plus the width-m expressions it satisfies
+    owned_true_counts_.assign(TrueCountsSize(n), 0);
+    for (std::size_t m = 0; m <= n; ++m) {
+        const std::size_t entries = std::size_t(1) << m;
+        std::uint32_t* level = owned_true_counts_.data() + entries - 1;
+        const std::uint32_t* previous = level - entries / 2;
+        const std::vector<std::size_t>& members = by_width[m];
+
+        // Every block is a full pass over members, so split even a few
+        pool.Run((entries + 63) / 64, [&](std::size_t begin, std::size_t end, std::size_t) {
+            for (std::size_t block = begin; block < end; ++block) {
+                AssignmentBatch batch;
+                for (std::size_t j = 0; j < 26; ++j) {
+                    batch.values[j] = j < 6 ? kLanePatterns[j]
+                                    : (block >> (j - 6) & 1) ? ~std::uint64_t(0) : 0;
+                    batch.defined[j] = ~std::uint64_t(0);
+                }
+                batch.size = std::min<std::size_t>(64, entries - 64 * block);
+
+                SlicedCounter satisfied;
+                for (std::size_t i : members) {
+                    std::uint64_t failed;
+                    satisfied.Add(table.Evaluate(i, batch, &failed));
+                }
+
+                for (std::size_t k = 0; k < batch.size; ++k) {
+                    std::size_t v = 64 * block + k;
+                    level[v] = (m ? previous[v & (entries / 2 - 1)] : 0) + satisfied.Count(k);
+                }
+            }
+        }, 1);
+    }
+
+    valid_ = true;
+    generation_ = table.Generation();
+    fingerprint_ = Fingerprint(table);
+    n_variables_ = n;
+    n_expressions_ = table.Size();
+    error_counts_ = owned_error_counts_.data();
+    true_counts_ = owned_true_counts_.data();
+    return true;
+}
+
+
+bool TruthTableIndex::Load(const std::string& path, const ExpressionTable& table) {
+    Clear();
+
+    // OPENING FILE
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        err_msg_ = "Could not open " + path + ": " + ::strerror(errno);
+        return false;
+    }
+
+    struct stat sb;
+    if (::fstat(fd, &sb) < 0
+        || static_cast<std::size_t>(sb.st_size) < sizeof(FileHeader)) {
+        ::close(fd);
+        err_msg_ = "Not a truth table index: " + path;
+        return false;
+    }
+
+    // MEMORY MAPPING FILE
+    void* addr = ::mmap(nullptr, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // the mapping outlives the descriptor
+    if (addr == MAP_FAILED) {
+        err_msg_ = "Could not map " + path + ": " + ::strerror(errno);
+        return false;
+    }
+
+    const char* bytes = static_cast<const char*>(addr);
+    FileHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+
+    std::size_t size = sb.st_size;
+    bool valid = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0
+              && header.version == kVersion
+              && header.n_variables <= 26
+              && size == sizeof(FileHeader)
+                         + (header.n_variables + 1 + TrueCountsSize(header.n_variables))
+                           * sizeof(std::uint32_t);
+    if (!valid) {
+        ::munmap(addr, sb.st_size);
+        err_msg_ = "Corrupt or unsupported truth table index: " + path;
+        return false;
+    }
+
+    if (header.n_expressions != table.Size() || header.fingerprint != Fingerprint(table)) {
+        ::munmap(addr, sb.st_size);
+        err_msg_ = "Truth table index " + path + " is for other expressions";
+        return false;
+    }
+
+    mapping_ = addr;
+    mapping_size_ = size;
+    valid_ = true;
+    generation_ = table.Generation();
+    fingerprint_ = header.fingerprint;
+    n_variables_ = header.n_variables;
+    n_expressions_ = header.n_expressions;
+    error_counts_ = reinterpret_cast<const std::uint32_t*>(bytes + sizeof(FileHeader));
+    true_counts_ = error_counts_ + n_variables_ + 1;
+    return true;
+}
+
+
+bool TruthTableIndex::Save(const std::string& path) const {
+    if (!valid_) {
+        err_msg_ = "No index to save";
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        err_msg_ = "Could not create " + path;
+        return false;
+    }
+
+    FileHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.n_variables = n_variables_;
+    header.n_expressions = n_expressions_;
+    header.fingerprint = fingerprint_;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(error_counts_),
+               (n_variables_ + 1) * sizeof(std::uint32_t));
+    file.write(reinterpret_cast<const char*>(true_counts_),
+               TrueCountsSize(n_variables_) * sizeof(std::uint32_t));
+    if (!file) {
+        err_msg_ = "Could not write " + path;
+        return false;
+    }
+    return true;
+}
+
+
+bool TruthTableIndex::Lookup(std::uint64_t generation, const TruthAssignment& assignment,
+                             ResultCounts* counts) const {
+    if (!valid_ || generation != generation_) return false;
+
+    // Requests always define a prefix a, b, ...; anything else is not indexed
+    std::size_t length = __builtin_popcount(assignment.defined);
+    if (assignment.defined != (std::uint32_t(1) << length) - 1) return false;
+
+    // Values past the indexed variables cannot change any result
+    std::size_t level = std::min(length, n_variables_);
+    std::uint32_t values = assignment.values & ((std::uint32_t(1) << level) - 1);
+
+    counts->true_count = true_counts_[(std::size_t(1) << level) - 1 + values];
+    counts->error_count = error_counts_[level];
+    counts->false_count = n_expressions_ - counts->true_count - counts->error_count;
+    return true;
+}
+
+
+std::uint64_t TruthTableIndex::Fingerprint(const ExpressionTable& table) {
+    // FNV-1a over every expression's terms, and where each one ends
+    const std::uint64_t kPrime = 0x100000001b3ull;
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    auto mix = [&](std::uint32_t word) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            hash = (hash ^ (word >> shift & 0xff)) * kPrime;
+        }
+    };
+
+    for (std::size_t i = 0; i < table.Size(); ++i) {
+        mix(table.TermsEnd(i) - table.TermsBegin(i));
+        for (const ExpressionTable::Term* term = table.TermsBegin(i);
+             term != table.TermsEnd(i); ++term) {
+            mix(term->positive);
+            mix(term->negative);
+        }
+    }
+    return hash;
+}
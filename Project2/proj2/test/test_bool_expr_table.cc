@@ -0,0 +1,143 @@
+// Checks that an ExpressionTable saved and loaded again evaluates as the
+// one it was saved from, and that Load rejects files that are truncated,
+// are not a table, or hold term offsets that point outside it.
+//
+
+#include <bool_expr_compiler.h>
+#include <bool_expr_parser.h>
+#include <bool_expr_table.h>
+#include <test_util.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace {
+
+const char* const kExpressions[] = {
+    "a * b' + c",
+    "a' * d",
+    "b * c * d' + a * e + f",
+    "a * + b",
+};
+
+// Where the header ends and first_term begins
+const std::size_t kHeaderSize = 16;
+
+void StoreUint32(std::string* contents, std::size_t offset, std::uint32_t value) {
+    std::memcpy(&(*contents)[offset], &value, sizeof(value));
+}
+
+// True if both tables give every expression the same result under every
+// assignment to a through f
+bool SameResults(const ExpressionTable& a, const ExpressionTable& b) {
+    if (a.Size() != b.Size() || a.TermCount() != b.TermCount()) return false;
+    for (std::uint32_t values = 0; values < 64; ++values) {
+        TruthAssignment assignment = {values, 0x3f};
+        for (std::size_t i = 0; i < a.Size(); ++i) {
+            bool a_error = false, b_error = false;
+            if (a.Evaluate(i, assignment, &a_error) != b.Evaluate(i, assignment, &b_error)
+                || a_error != b_error)
+                return false;
+        }
+    }
+    return true;
+}
+
+void TestRoundTrip() {
+    ExpressionTable saved;
+    for (const char* line : kExpressions)
+        saved.Append(CompiledExpression(Explode(line, ' ')));
+
+    std::string path = TempPath();
+    ExpressionTable loaded;
+    Check(saved.Save(path) && ExpressionTable::IsBinary(path) && loaded.Load(path),
+          "a saved table loads");
+    Check(SameResults(saved, loaded), "a loaded table evaluates as the saved one");
+    Check(loaded.HasError(3), "an expression that did not compile stays an error");
+    Check(!loaded.Append(CompiledExpression(Explode("a", ' '))),
+          "a mapped table cannot be appended to");
+
+    // A file that is not sealed is copied, so truncating it later is harmless
+    int fd = ::open(path.c_str(), O_RDONLY);
+    ExpressionTable from_fd;
+    Check(fd >= 0 && from_fd.Load(fd, path) && SameResults(saved, from_fd),
+          "a table loads from an open descriptor");
+    if (fd >= 0) ::close(fd);
+    Check(::truncate(path.c_str(), 0) == 0 && SameResults(saved, from_fd),
+          "a table read from an unsealed file survives its truncation");
+
+    // A sealed memfd is mapped
+    saved.Save(path);
+    std::string contents = ReadFile(path);
+    int memfd = ::memfd_create("table", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    bool sealed = memfd >= 0
+               && ::write(memfd, contents.data(), contents.size())
+                  == static_cast<ssize_t>(contents.size())
+               && ::fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_WRITE) == 0;
+    ExpressionTable from_memfd;
+    Check(sealed && from_memfd.Load(memfd, "memfd") && SameResults(saved, from_memfd)
+          && !from_memfd.Append(CompiledExpression(Explode("a", ' '))),
+          "a table in a sealed memfd is mapped");
+    if (memfd >= 0) ::close(memfd);
+
+    ::unlink(path.c_str());
+}
+
+void TestRejected() {
+    ExpressionTable saved;
+    for (const char* line : kExpressions)
+        saved.Append(CompiledExpression(Explode(line, ' ')));
+    std::string path = TempPath();
+    if (!saved.Save(path))
+        return Check(false, "save a table to corrupt");
+    std::string contents = ReadFile(path);
+
+    ExpressionTable loaded;
+    WriteFile(path, contents.substr(0, contents.size() - 8));
+    Check(!loaded.Load(path), "a table missing its last term is rejected");
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    Check(fd >= 0 && !loaded.Load(fd, path),
+          "a table missing its last term is rejected when read from a descriptor");
+    if (fd >= 0) ::close(fd);
+
+    WriteFile(path, contents.substr(0, kHeaderSize - 1));
+    Check(!loaded.Load(path), "a file shorter than the header is rejected");
+
+    std::string bad = contents;
+    bad[0] = 'X';
+    WriteFile(path, bad);
+    Check(!ExpressionTable::IsBinary(path) && !loaded.Load(path),
+          "a file with the wrong magic is rejected");
+
+    bad = contents;
+    StoreUint32(&bad, 4, ExpressionTable::kVersion + 1);
+    WriteFile(path, bad);
+    Check(!loaded.Load(path), "a file of another version is rejected");
+
+    bad = contents;
+    StoreUint32(&bad, 8, 1 << 30);
+    WriteFile(path, bad);
+    Check(!loaded.Load(path), "a count of expressions past the end of the file is rejected");
+
+    bad = contents;
+    StoreUint32(&bad, kHeaderSize + 4, saved.TermCount() + 1);
+    WriteFile(path, bad);
+    Check(!loaded.Load(path), "a term offset past the last term is rejected");
+
+    ::unlink(path.c_str());
+}
+
+}  // namespace
+
+int main() {
+    TestRoundTrip();
+    TestRejected();
+
+    return failures == 0 ? 0 : 1;
+}
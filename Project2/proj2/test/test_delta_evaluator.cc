@@ -0,0 +1,133 @@
+// Walks a DeltaEvaluator through random assignments that each change a
+// variable or two, checking every count and every kept result against a
+// full evaluation, and that it refuses state it cannot bring up to date.
+//
+
+#include <bool_expr_compiler.h>
+#include <bool_expr_parser.h>
+#include <bool_expr_table.h>
+#include <delta_evaluator.h>
+#include <test_util.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+namespace {
+
+// Expressions of a few terms over two or three of all 26 variables, so a
+// change to one variable affects few of them
+void Fill(std::mt19937& random, ExpressionTable* table) {
+    for (std::size_t i = 0; i < 400; ++i) {
+        char variables[3];
+        for (char& variable : variables) variable = 'a' + random() % 26;
+
+        std::string text;
+        for (std::size_t t = 0, n_terms = 1 + random() % 3; t < n_terms; ++t) {
+            if (t) text += " + ";
+            for (std::size_t v = 0, n_literals = 2 + random() % 2; v < n_literals; ++v) {
+                if (v) text += " * ";
+                text += variables[v];
+                if (random() % 2) text += '\'';
+            }
+        }
+        table->Append(CompiledExpression(Explode(text.c_str(), ' ')));
+    }
+}
+
+// Evaluates every expression, as the server does before Record, keeping
+// each result as Scan does not
+ResultCounts Full(const ExpressionTable& table, const TruthAssignment& assignment,
+                  DeltaState* state) {
+    ResultCounts counts = {0, 0, 0};
+    state->results.assign(table.Size(), DeltaEvaluator::kError);
+    for (std::size_t i = 0; i < table.Size(); ++i) {
+        bool error = false;
+        bool result = table.Evaluate(i, assignment, &error);
+        if (error) {
+            counts.error_count++;
+        } else if (result) {
+            counts.true_count++;
+            state->results[i] = DeltaEvaluator::kTrue;
+        } else {
+            counts.false_count++;
+            state->results[i] = DeltaEvaluator::kFalse;
+        }
+    }
+    return counts;
+}
+
+void TestRandomWalk() {
+    std::mt19937 random(311);
+    ExpressionTable table;
+    Fill(random, &table);
+    DeltaEvaluator delta(table);
+
+    DeltaState state;
+    TruthAssignment assignment = BuildAssignment(std::string(26, 'F'));
+    delta.Record(assignment, Full(table, assignment, &state), &state);
+
+    std::size_t updated = 0;
+    bool counts_match = true, results_match = true;
+    for (std::size_t step = 0; step < 2000; ++step) {
+        // Flip a value, or define or undefine a variable, once or twice
+        for (std::size_t n = 1 + random() % 2; n > 0; --n) {
+            std::uint32_t bit = std::uint32_t(1) << random() % 26;
+            if (random() % 4) {
+                assignment.values ^= bit;
+            } else {
+                assignment.defined ^= bit;
+            }
+        }
+        assignment.values &= assignment.defined;
+
+        DeltaState expected;
+        ResultCounts full = Full(table, assignment, &expected);
+        ResultCounts counts;
+        if (delta.Update(assignment, &state, &counts)) {
+            ++updated;
+            counts_match = counts_match && Same(counts, full);
+            results_match = results_match && state.results == expected.results;
+        } else {
+            state.results = expected.results;
+            delta.Record(assignment, full, &state);
+        }
+    }
+
+    Check(updated > 1000, "most small changes are evaluated as deltas");
+    Check(counts_match, "delta counts match a full evaluation");
+    Check(results_match, "every kept result matches a full evaluation");
+}
+
+void TestRefused() {
+    std::mt19937 random(311);
+    ExpressionTable table;
+    Fill(random, &table);
+    DeltaEvaluator delta(table);
+
+    DeltaState state;
+    ResultCounts counts;
+    TruthAssignment assignment = BuildAssignment("TF");
+    Check(!delta.Update(assignment, &state, &counts), "state without results is refused");
+
+    delta.Record(assignment, Full(table, assignment, &state), &state);
+    TruthAssignment everything = BuildAssignment(std::string(26, 'T'));
+    Check(!delta.Update(everything, &state, &counts),
+          "a change affecting most expressions is left to a full evaluation");
+    Check(state.assignment.values == assignment.values
+          && state.assignment.defined == assignment.defined,
+          "refused state is left untouched");
+
+    table.Append(CompiledExpression(Explode("a * b", ' ')));
+    Check(!delta.Update(BuildAssignment("TT"), &state, &counts),
+          "state for a table that has since changed is refused");
+}
+
+}  // namespace
+
+int main() {
+    TestRandomWalk();
+    TestRefused();
+
+    return failures == 0 ? 0 : 1;
+}
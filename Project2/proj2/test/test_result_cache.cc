@@ -0,0 +1,95 @@
+// Checks ResultCache's CLOCK replacement, that a new expression-set
+// generation drops every entry, and that concurrent lookups and inserts
+// never return another key's counts.
+//
+
+#include <result_cache.h>
+#include <test_util.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+
+ResultCache::Counts CountsFor(std::uint64_t key) {
+    return ResultCache::Counts{static_cast<int>(key), static_cast<int>(key + 1), 0};
+}
+
+bool Holds(ResultCache& cache, std::uint64_t key, std::uint64_t generation = 1) {
+    ResultCache::Counts counts;
+    return cache.Lookup(key, generation, &counts) && counts.true_count == static_cast<int>(key)
+        && counts.false_count == static_cast<int>(key + 1);
+}
+
+void TestClockEviction() {
+    ResultCache cache(3);
+    for (std::uint64_t key = 1; key <= 3; ++key) cache.Insert(key, 1, CountsFor(key));
+    Check(Holds(cache, 1) && Holds(cache, 2) && Holds(cache, 3), "a cache holds its capacity");
+
+    // Every entry was just hit; the hand clears them all and evicts the
+    // first it reaches again
+    cache.Insert(4, 1, CountsFor(4));
+    Check(!Holds(cache, 1), "the hand evicts the oldest when every entry was hit");
+
+    // The hand now points at 2; hitting it again spares it, so 3 goes
+    Check(Holds(cache, 2), "a hit entry survives");
+    cache.Insert(5, 1, CountsFor(5));
+    Check(!Holds(cache, 3), "the hand evicts the entry not hit since it last passed");
+    Check(Holds(cache, 2) && Holds(cache, 4) && Holds(cache, 5), "the other entries survive");
+}
+
+void TestGenerations() {
+    ResultCache cache(8);
+    cache.Insert(1, 1, CountsFor(1));
+    Check(Holds(cache, 1, 1), "an entry is found in its generation");
+    Check(!Holds(cache, 1, 2), "an entry is not found in a later generation");
+    Check(!Holds(cache, 1, 1), "a new generation drops every entry");
+
+    cache.Insert(2, 2, CountsFor(2));
+    Check(Holds(cache, 2, 2), "entries of the new generation are kept");
+}
+
+void TestDisabled() {
+    ResultCache cache(0);
+    cache.Insert(1, 1, CountsFor(1));
+    Check(!Holds(cache, 1), "a cache of capacity 0 holds nothing");
+    Check(cache.Hits() == 0 && cache.Misses() == 1, "a disabled cache counts misses");
+}
+
+void TestConcurrent() {
+    const std::uint64_t kKeys = 256;
+    ResultCache cache(64);
+    std::vector<char> consistent(4, 1);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < consistent.size(); ++t) {
+        threads.emplace_back([&, t]() {
+            for (std::uint64_t i = 0; i < 20000; ++i) {
+                std::uint64_t key = (i * 7 + t) % kKeys;
+                ResultCache::Counts counts;
+                if (cache.Lookup(key, 1, &counts)) {
+                    if (counts.true_count != static_cast<int>(key)) consistent[t] = 0;
+                } else {
+                    cache.Insert(key, 1, CountsFor(key));
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    bool all = true;
+    for (char ok : consistent) all = all && ok;
+    Check(all, "concurrent lookups only find their own key's counts");
+    Check(cache.Hits() + cache.Misses() == 4 * 20000, "every lookup is counted once");
+}
+
+}  // namespace
+
+int main() {
+    TestClockEviction();
+    TestGenerations();
+    TestDisabled();
+    TestConcurrent();
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+// Checks TermIndex against evaluating every expression, on random
+// expressions and assignments, from one thread and several, and with two
+// indexes of different sizes sharing a thread's bitmap of expressions seen.
+//
+
+#include <bool_expr_compiler.h>
+#include <bool_expr_parser.h>
+#include <bool_expr_table.h>
+#include <term_index.h>
+#include <test_util.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Expressions of up to four terms over the first n_variables variables.
+// Some terms hold a variable and its complement, and some expressions do
+// not compile.
+void Fill(std::mt19937& random, std::size_t n_expressions, std::size_t n_variables,
+          ExpressionTable* table) {
+    for (std::size_t i = 0; i < n_expressions; ++i) {
+        std::string text;
+        for (std::size_t t = 0, n_terms = 1 + random() % 4; t < n_terms; ++t) {
+            if (t) text += " + ";
+            for (std::size_t v = 0, n_literals = 1 + random() % 4; v < n_literals; ++v) {
+                if (v) text += " * ";
+                text += static_cast<char>('a' + random() % n_variables);
+                if (random() % 2) text += '\'';
+            }
+        }
+        if (random() % 50 == 0) text += " *";
+        table->Append(CompiledExpression(Explode(text.c_str(), ' ')));
+    }
+}
+
+// Requests define a prefix of the variables; other masks are checked too
+TruthAssignment RandomAssignment(std::mt19937& random, std::size_t n_variables) {
+    TruthAssignment assignment;
+    std::size_t length = random() % (n_variables + 2);
+    assignment.defined = random() % 4 ? (std::uint32_t(1) << length) - 1
+                                      : random() & ((std::uint32_t(1) << n_variables) - 1);
+    assignment.values = random() & assignment.defined;
+    return assignment;
+}
+
+bool Matches(const TermIndex& index, const ExpressionTable& table,
+             const TruthAssignment& assignment) {
+    ResultCounts indexed;
+    return index.Evaluate(assignment, &indexed) && Same(indexed, Scan(table, assignment));
+}
+
+void TestAgainstScan() {
+    std::mt19937 random(311);
+    ExpressionTable small, large;
+    Fill(random, 100, 6, &small);
+    Fill(random, 3000, 12, &large);
+    TermIndex small_index(small), large_index(large);
+
+    // Alternating keeps a bitmap sized for the large table in use for the
+    // small one, which must find it clear
+    bool match = true;
+    for (std::size_t k = 0; k < 2000 && match; ++k) {
+        match = Matches(large_index, large, RandomAssignment(random, 12))
+             && Matches(small_index, small, RandomAssignment(random, 6));
+    }
+    Check(match, "every count matches a scan");
+}
+
+void TestConcurrent() {
+    std::mt19937 random(311);
+    ExpressionTable table;
+    Fill(random, 3000, 12, &table);
+    TermIndex index(table);
+
+    std::vector<char> match(4, 1);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < match.size(); ++t) {
+        threads.emplace_back([&, t]() {
+            std::mt19937 thread_random(t);
+            for (std::size_t k = 0; k < 300 && match[t]; ++k)
+                match[t] = Matches(index, table, RandomAssignment(thread_random, 12));
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    bool all = true;
+    for (char ok : match) all = all && ok;
+    Check(all, "concurrent counts match a scan");
+}
+
+void TestChangedTable() {
+    ExpressionTable table;
+    table.Append(CompiledExpression(Explode("a * b", ' ')));
+    TermIndex index(table);
+    table.Append(CompiledExpression(Explode("a' * b", ' ')));
+
+    ResultCounts counts;
+    Check(!index.Evaluate(BuildAssignment("TT"), &counts),
+          "an index for a table that has since changed refuses to count");
+}
+
+}  // namespace
+
+int main() {
+    TestAgainstScan();
+    TestConcurrent();
+    TestChangedTable();
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+// Checks TruthTableIndex against evaluating every expression, through a
+// save and load, and that Load rejects files that are truncated, are not
+// an index, or describe other expressions.
+//
+
+#include <bool_expr_compiler.h>
+#include <bool_expr_parser.h>
+#include <bool_expr_table.h>
+#include <evaluator_pool.h>
+#include <test_util.h>
+#include <truth_table_index.h>
+
+#include <unistd.h>
+
+#include <string>
+
+namespace {
+
+// Widths up to i, so levels past the first 64 assignments are built too,
+// and one expression that does not compile
+const char* const kExpressions[] = {
+    "a * b' + c",
+    "a' * d",
+    "b * c * d' + a * e",
+    "f' * g + h * i'",
+    "e * h + b'",
+    "a * + b",
+};
+
+void Fill(ExpressionTable* table) {
+    for (const char* line : kExpressions)
+        table->Append(CompiledExpression(Explode(line, ' ')));
+}
+
+// True if the index answers every prefix of every length as a scan does
+bool MatchesScan(const TruthTableIndex& index, const ExpressionTable& table) {
+    for (std::size_t length = 0; length <= index.Variables() + 1; ++length) {
+        for (std::size_t v = 0; v < (std::size_t(1) << length); ++v) {
+            std::string values;
+            for (std::size_t j = 0; j < length; ++j) values += (v >> j & 1) ? 'T' : 'F';
+            TruthAssignment assignment = BuildAssignment(values);
+
+            ResultCounts indexed;
+            if (!index.Lookup(table.Generation(), assignment, &indexed)
+                || !Same(indexed, Scan(table, assignment)))
+                return false;
+        }
+    }
+    return true;
+}
+
+void TestBuild(EvaluatorPool& pool) {
+    ExpressionTable table;
+    Fill(&table);
+    TruthTableIndex index;
+    Check(index.Build(table, pool) && index.Variables() == 9, "an index is built over 9 variables");
+    Check(MatchesScan(index, table), "every lookup matches a scan");
+
+    ResultCounts counts;
+    Check(!index.Lookup(table.Generation() + 1, BuildAssignment("T"), &counts),
+          "a lookup for another generation fails");
+    Check(!index.Lookup(table.Generation(), TruthAssignment{1, 2}, &counts),
+          "a lookup for values that are not a prefix fails");
+
+    TruthTableIndex narrow;
+    Check(!narrow.Build(table, pool, 8), "a table wider than max_variables is not indexed");
+}
+
+void TestSaveAndLoad(EvaluatorPool& pool) {
+    ExpressionTable table;
+    Fill(&table);
+    TruthTableIndex built;
+    std::string path = TempPath();
+    if (!built.Build(table, pool) || !built.Save(path))
+        return Check(false, "save an index");
+
+    TruthTableIndex loaded;
+    Check(loaded.Load(path, table) && MatchesScan(loaded, table), "a saved index loads intact");
+
+    std::string contents = ReadFile(path);
+    std::string bad = path + ".bad";
+
+    WriteFile(bad, contents.substr(0, contents.size() - 4));
+    Check(!loaded.Load(bad, table), "a truncated index is rejected");
+
+    WriteFile(bad, contents.substr(0, 10));
+    Check(!loaded.Load(bad, table), "a file shorter than the header is rejected");
+
+    std::string wrong_magic = contents;
+    wrong_magic[0] = 'X';
+    WriteFile(bad, wrong_magic);
+    Check(!loaded.Load(bad, table), "a file with the wrong magic is rejected");
+
+    ExpressionTable other;
+    Fill(&other);
+    other.Append(CompiledExpression(Explode("a * b", ' ')));
+    Check(!loaded.Load(path, other), "an index for other expressions is rejected");
+
+    ::unlink(path.c_str());
+    ::unlink(bad.c_str());
+}
+
+}  // namespace
+
+int main() {
+    EvaluatorPool pool(2);
+    TestBuild(pool);
+    TestSaveAndLoad(pool);
+
+    return failures == 0 ? 0 : 1;
+}
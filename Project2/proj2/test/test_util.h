@@ -0,0 +1,59 @@
+// What the tests here share: the check from ipc/test/test_check.h, a scan
+// that evaluates every expression to count results the slow, sure way, and
+// scratch files.
+//
+
+#ifndef TEST_UTIL_H_
+#define TEST_UTIL_H_
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <bool_expr_protocol.h>
+#include <bool_expr_table.h>
+#include <test_check.h>
+
+// Counts the results of assignment by evaluating each expression in turn
+inline ResultCounts Scan(const ExpressionTable& table, const TruthAssignment& assignment) {
+    ResultCounts counts = {0, 0, 0};
+    for (std::size_t i = 0; i < table.Size(); ++i) {
+        bool error = false;
+        bool result = table.Evaluate(i, assignment, &error);
+        if (error) {
+            counts.error_count++;
+        } else if (result) {
+            counts.true_count++;
+        } else {
+            counts.false_count++;
+        }
+    }
+    return counts;
+}
+
+inline bool Same(const ResultCounts& a, const ResultCounts& b) {
+    return a.true_count == b.true_count && a.false_count == b.false_count
+        && a.error_count == b.error_count;
+}
+
+// A new empty file under /tmp, which the caller removes
+inline std::string TempPath() {
+    char path[] = "/tmp/bool_expr_testXXXXXX";
+    int fd = ::mkstemp(path);
+    if (fd >= 0) ::close(fd);
+    return path;
+}
+
+inline std::string ReadFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+inline void WriteFile(const std::string& path, const std::string& contents) {
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+}
+
+#endif  // TEST_UTIL_H_
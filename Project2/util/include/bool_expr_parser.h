@@ -17,6 +17,7 @@
 #define UTIL_INCLUDE_BOOL_EXPR_PARSER_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <unordered_map>
@@ -37,6 +38,26 @@ const std::string Explode(const char input[], char delim = ' ');
 const std::unordered_map<char, bool> BuildMap(const std::string& boolean_values);
 
 
+//
+// A dense alternative to the map above, for hot loops: bit i of values holds
+// the value of variable char('a' + i), and bit i of defined is set when that
+// variable has a value at all. Lookups are a shift and a mask with no heap
+// allocation.
+//
+struct TruthAssignment {
+  std::uint32_t values;
+  std::uint32_t defined;
+};
+
+
+//
+// Constructs a TruthAssignment for a, b, c, ... from the Boolean values
+// supplied ('T' is true, anything else false), like BuildMap. Values past
+// the 26th are ignored.
+//
+const TruthAssignment BuildAssignment(const std::string& boolean_values);
+
+
 //
 // A Boolean expression parser, capable of parsing variables, a-z, ORs +,
 // ANDs *, and complemented variables, e.g., a' or z'.
@@ -45,8 +66,15 @@ class BooleanExpressionParser {
  public:
   BooleanExpressionParser(const std::string& expression,
               const std::unordered_map<char, bool>& values)
-    : expression_(expression), values_(values), currentIndex_(0),
-      has_error_(0), err_msg_("") {
+    : expression_(expression), values_(&values), assignment_(nullptr),
+      currentIndex_(0), has_error_(0), err_msg_("") {
+    // empty
+  }
+
+  BooleanExpressionParser(const std::string& expression,
+              const TruthAssignment& assignment)
+    : expression_(expression), values_(nullptr), assignment_(&assignment),
+      currentIndex_(0), has_error_(0), err_msg_("") {
     // empty
   }
 
@@ -72,11 +100,15 @@ class BooleanExpressionParser {
   // Parse primary values: variables (a-z), optionally negated with `'`
   bool ParseFactor();
 
+  // Looks up a variable in whichever of values_ or assignment_ is set
+  bool Lookup(char variable, bool* value) const;
+
   void ReportError(const std::string& message);
 
 
   std::string expression_;
-  const std::unordered_map<char, bool>& values_;
+  const std::unordered_map<char, bool>* values_;
+  const TruthAssignment* assignment_;
   size_t currentIndex_;
   bool has_error_;
   std::string err_msg_;
@@ -0,0 +1,217 @@
+// Copyright CSCE 311 Spring 2025
+//
+// A set of compiled DNF expressions stored as one flat table of product terms
+// (see CompiledExpression::Term), plus its on-disk form. Evaluating an
+// expression from the table needs no parsing at all, and a saved table can be
+// mmap'd and used in place, so loading a large set costs no more than opening
+// the file.
+//
+// Binary file layout, all fields in host byte order (the version reads as a
+// different number on a machine of the other endianness, so such files are
+// rejected rather than misread):
+//
+//   char     magic[4]        "BXPR"
+//   uint32_t version         kVersion
+//   uint32_t n_expressions
+//   uint32_t n_terms
+//   uint32_t first_term[n_expressions + 1]   expression i owns terms
+//                                             [first_term[i], first_term[i+1])
+//   padding to a multiple of 8 bytes
+//   Term     terms[n_terms]  { uint32_t positive, negative }
+//
+// An expression that failed to compile is stored as the single term
+// kErrorTerm, so it still counts as an expression (and as an error).
+//
+
+#ifndef UTIL_INCLUDE_BOOL_EXPR_TABLE_H_
+#define UTIL_INCLUDE_BOOL_EXPR_TABLE_H_
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <bool_expr_compiler.h>
+#include <bool_expr_parser.h>
+
+
+//
+// Up to 64 truth assignments side by side, for evaluating a whole batch in
+// one pass over the table: bit k of values[j] (defined[j]) is bit j of the
+// k-th assignment's values (defined).
+//
+struct AssignmentBatch {
+  static const std::size_t kMaxSize = 64;
+
+  std::uint64_t values[26];
+  std::uint64_t defined[26];
+  std::size_t size;
+
+  AssignmentBatch() : values(), defined(), size(0) {
+    // empty
+  }
+
+  // Adds an assignment as lane size; returns false once the batch is full
+  bool Add(const TruthAssignment& assignment);
+
+  // Bit k is set for each lane in use
+  std::uint64_t Lanes() const {
+    return size == kMaxSize ? ~std::uint64_t(0)
+                            : (std::uint64_t(1) << size) - 1;
+  }
+};
+
+
+//
+// 64 counters side by side, for totalling batch results: bit k of planes[b]
+// is bit b of counter k, so adding a whole batch's result bits takes a few
+// instructions rather than 64 increments.
+//
+struct SlicedCounter {
+  std::uint64_t planes[32];
+
+  SlicedCounter() : planes() {
+    // empty
+  }
+
+  // Adds one to counter k for each bit k set in lanes
+  void Add(std::uint64_t lanes) {
+    for (std::size_t b = 0; lanes; ++b) {
+      std::uint64_t carry = planes[b] & lanes;
+      planes[b] ^= lanes;
+      lanes = carry;
+    }
+  }
+
+  std::uint32_t Count(std::size_t k) const {
+    std::uint32_t count = 0;
+    for (std::size_t b = 0; b < 32; ++b)
+      count |= static_cast<std::uint32_t>(planes[b] >> k & 1) << b;
+    return count;
+  }
+};
+
+
+class ExpressionTable {
+ public:
+  typedef CompiledExpression::Term Term;
+
+  static const std::uint32_t kVersion = 1;
+
+  // Marks an expression that did not compile; no real term sets bits past z
+  static const Term kErrorTerm;
+
+  ExpressionTable();
+
+  // Unmaps the file if the table was loaded
+  ~ExpressionTable();
+
+  // Adds a compiled expression to the end of an in-memory table. Returns
+  // false if the table is mapped from a file or the expression is not DNF.
+  bool Append(const CompiledExpression& expression);
+
+  // Replaces the contents with a mapping of a file written by Save
+  bool Load(const std::string& path);
+
+  // As above for a file already open, e.g., one passed by another process;
+  // path only names it in errors. The descriptor is not closed. Only a file
+  // sealed against shrinking and writing (F_SEAL_SHRINK | F_SEAL_WRITE) is
+  // mapped; any other is read into memory, so its owner cannot truncate or
+  // rewrite the table while it is in use.
+  bool Load(int fd, const std::string& path);
+
+  bool Save(const std::string& path) const;
+
+  // True if the file starts with the binary magic number
+  static bool IsBinary(const std::string& path);
+
+  std::size_t Size() const {
+    return n_expressions_;
+  }
+
+  std::size_t TermCount() const {
+    return n_expressions_ ? first_term_[n_expressions_] : 0;
+  }
+
+  // Expression i's terms
+  const Term* TermsBegin(std::size_t i) const {
+    return terms_ + first_term_[i];
+  }
+
+  const Term* TermsEnd(std::size_t i) const {
+    return terms_ + first_term_[i + 1];
+  }
+
+  bool HasError(std::size_t i) const;
+
+  // Bit j is set when variable char('a' + j) appears in expression i
+  std::uint32_t Variables(std::size_t i) const;
+
+  // As CompiledExpression::Satisfiable, straight from the terms
+  bool Satisfiable(std::size_t i, std::size_t n_variables) const;
+
+  // As CompiledExpression::Evaluate, straight from the terms
+  bool Evaluate(std::size_t i, const TruthAssignment& assignment,
+                bool* error = nullptr) const;
+
+  // Evaluates expression i under every assignment of the batch at once. Bit
+  // k of the result is its value under the k-th assignment, and bit k of
+  // *errors is set when the k-th assignment leaves one of its variables
+  // undefined (the result bit is clear then).
+  std::uint64_t Evaluate(std::size_t i, const AssignmentBatch& batch,
+                         std::uint64_t* errors) const;
+
+  // Changes whenever the table's contents do, and is never shared with
+  // another table, so results computed from the table can be cached
+  // against it
+  std::uint64_t Generation() const {
+    return generation_;
+  }
+
+  // Describes why the last Load or Save failed
+  const std::string Error() const {
+    return err_msg_;
+  }
+
+ private:
+  // Loads from fd, by mapping it or by reading it into the owned vectors
+  bool Load(int fd, const std::string& path, bool map);
+
+  // Reads and checks a table of size bytes into the owned vectors
+  bool Read(int fd, std::size_t size, const std::string& path);
+
+  // Releases any mapping and empties the table
+  void Clear();
+
+  // Points first_term_ and terms_ at the owned vectors after they change,
+  // and starts a new generation
+  void Refresh();
+
+  std::vector<std::uint32_t> owned_first_term_;
+  std::vector<Term> owned_terms_;
+
+  void* mapping_;
+  std::size_t mapping_size_;
+
+  std::size_t n_expressions_;
+  const std::uint32_t* first_term_;
+  const Term* terms_;
+  std::uint64_t generation_;
+
+  mutable std::string err_msg_;
+
+  // Non-copyable, non-movable
+  ExpressionTable(const ExpressionTable&) = delete;
+  ExpressionTable& operator=(const ExpressionTable&) = delete;
+};
+
+
+//
+// Decides expression i as SatSolver does, reporting errors to stderr the same
+// way.
+//
+bool SatSolver(std::size_t n, const ExpressionTable& table, std::size_t i);
+
+
+#endif  // UTIL_INCLUDE_BOOL_EXPR_TABLE_H_
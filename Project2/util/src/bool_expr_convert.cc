@@ -0,0 +1,64 @@
+// Copyright CSCE 311 Spring 2025
+//
+// Converts a text file of Boolean expressions, one per line, into the binary
+// expression table format read by n-sat-solver and bool-expr-server (see
+// bool_expr_table.h). Blank lines and lines starting with '/' or '#' are
+// skipped; every other line becomes one expression, including those that do
+// not compile, which are stored as errors.
+//
+// Usage: bool-expr-convert <text file> <binary file>
+//
+
+#include <bool_expr_compiler.h>
+#include <bool_expr_table.h>
+
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+
+int main(int argc, char* argv[]) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <text file> <binary file>"
+              << std::endl;
+    return 1;
+  }
+
+  std::ifstream input(argv[1]);
+  if (!input) {
+    std::cerr << "Unable to open file: " << argv[1] << std::endl;
+    return 1;
+  }
+
+  ExpressionTable table;
+  std::size_t n_errors = 0;
+  std::size_t line_number = 0;
+  std::string line;
+  while (std::getline(input, line)) {
+    ++line_number;
+    std::size_t first = 0;
+    while (first < line.size()
+           && std::isspace(static_cast<unsigned char>(line[first])))
+      ++first;
+    if (first == line.size() || line[first] == '/' || line[first] == '#')
+      continue;
+
+    CompiledExpression expression(std::string_view(line).substr(first));
+    if (expression.HasError()) {
+      std::cerr << "Line " << line_number << ": " << expression.Error()
+                << std::endl;
+      ++n_errors;
+    }
+    table.Append(expression);
+  }
+
+  if (!table.Save(argv[2])) {
+    std::cerr << table.Error() << std::endl;
+    return 1;
+  }
+
+  std::cout << "Wrote " << table.Size() << " expressions (" << table.TermCount()
+            << " terms, " << n_errors << " errors) to " << argv[2] << std::endl;
+  return 0;
+}
@@ -1,5 +1,7 @@
 #include <bool_expr_parser.h>
 
+#include <algorithm>
+
 bool BooleanExpressionParser::Parse() {
   bool result = ParseExpr();
   if (has_error_ || currentIndex_ != expression_.size()) {
@@ -55,9 +57,7 @@ bool BooleanExpressionParser::ParseFactor() {
   if (std::isalpha(token)) {
     Consume(); // Consume the letter (e.g., 'a')
     bool value;
-    if (values_.find(token) != values_.end()) {
-      value = values_.at(token);
-    } else {
+    if (!Lookup(token, &value)) {
       ReportError("Undefined variable: " + std::string(1, token));
       return false;
     }
@@ -75,6 +75,24 @@ bool BooleanExpressionParser::ParseFactor() {
   }
 }
 
+bool BooleanExpressionParser::Lookup(char variable, bool* value) const {
+  if (assignment_) {
+    if (variable < 'a' || variable > 'z')
+      return false;
+
+    std::uint32_t bit = std::uint32_t(1) << (variable - 'a');
+    *value = assignment_->values & bit;
+    return assignment_->defined & bit;
+  }
+
+  auto it = values_->find(variable);  // a single hash lookup
+  if (it == values_->end())
+    return false;
+
+  *value = it->second;
+  return true;
+}
+
 void BooleanExpressionParser::ReportError(const std::string& message) {
   if (!has_error_) {
     err_msg_ = "Error: " + message;
@@ -109,3 +127,16 @@ const std::unordered_map<char, bool> BuildMap(const std::string& b_vals) {
   }
   return values;
 }
+
+
+const TruthAssignment BuildAssignment(const std::string& b_vals) {
+  TruthAssignment assignment = {0, 0};
+  std::size_t n_vals = std::min<std::size_t>(b_vals.size(), 26);
+  for (std::size_t i = 0; i < n_vals; ++i) {
+    std::uint32_t bit = std::uint32_t(1) << i;
+    assignment.defined |= bit;
+    if (b_vals[i] == 'T')
+      assignment.values |= bit;
+  }
+  return assignment;
+}
@@ -1,10 +1,17 @@
 #ifndef N_SAT_SOLVER_H_
 #define N_SAT_SOLVER_H_
 
+#include <atomic>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <pthread.h>
 
+#include <bool_expr_compiler.h>
+#include <bool_expr_table.h>
+#include <bounded_queue.h>
+
 struct ThreadStats {
     size_t thread_id;  // Needed for sorting results
     size_t sat_count;
@@ -14,17 +21,42 @@ struct ThreadStats {
     ThreadStats(size_t sat, size_t unsat) : thread_id(0), sat_count(sat), unsat_count(unsat) {}
 };
 
+// Shared by the threads searching slices of the same expression
+struct ExpressionSearch {
+    std::atomic<bool> found;          // set by whichever slice satisfies it
+    std::atomic<size_t> slices_left;  // last thread to finish records result
+};
+
+// Command-line tunables
+struct SolverOptions {
+    std::size_t chunk_size = 1;  // work items a thread claims at once
+    bool enumerate = false;      // brute force even expressions in DNF
+    bool stream = false;         // solve while reading; filename "-" is stdin
+};
+
 // Forward declaration
 class NSatSolver;
 
 struct ThreadData {
     size_t thread_id;
-    // These two fields can be removed as they're not used in the round-robin approach
-    // size_t start_idx;  
-    // size_t end_idx;
     NSatSolver* solver;
     ThreadStats stats;
-    std::vector<size_t> expression_indices;
+};
+
+// One newline-aligned byte range of the input, scanned and compiled by its
+// own thread
+struct LoadTask {
+    const char* begin;
+    const char* end;
+    std::vector<std::string_view> lines;
+    std::vector<CompiledExpression> programs;
+};
+
+// One streamed expression and its place in the input, so that results
+// solved out of order can still be printed in order
+struct StreamItem {
+    std::size_t index;
+    CompiledExpression program;
 };
 
 class ThreadMutexGuard {
@@ -43,22 +75,96 @@ private:
 
 class NSatSolver {
 public:
-    NSatSolver(std::size_t n_threads, const std::string& filename, std::size_t n_vars);
+    // Unless options.stream is set, the whole file is loaded here. Files
+    // written by bool-expr-convert are recognized and mapped as they are.
+    NSatSolver(std::size_t n_threads, const std::string& filename, std::size_t n_vars,
+               const SolverOptions& options = SolverOptions());
+
+    // Unmaps the input file the expressions point into
+    ~NSatSolver();
+
+    NSatSolver(const NSatSolver&) = delete;
+    NSatSolver& operator=(const NSatSolver&) = delete;
     
     void Solve();
     
 private:
     void LoadExpressions();
+
+    // Splits the mapped file into per-thread ranges that start on a line
+    static std::vector<LoadTask> SplitLines(const char* begin, const char* end,
+                                            std::size_t n_parts);
+    static void* ThreadLoad(void* arg);
     void PrintResults(const std::vector<ThreadStats>& stats);
+
+    // Creates n_workers threads running routine, each with its own ThreadData,
+    // then (after the caller has done any work of its own) joins them
+    void StartWorkers(std::size_t n_workers, void* (*routine)(void*),
+                      std::vector<pthread_t>* threads,
+                      std::vector<ThreadData*>* thread_data);
+    std::vector<ThreadStats> JoinWorkers(std::vector<pthread_t>& threads,
+                                         std::vector<ThreadData*>& thread_data);
     
     static void* ThreadSolve(void* arg);
+
+    // Streaming mode: this thread reads and compiles lines into queue_ while
+    // ThreadSolveStream workers pop and solve them
+    std::vector<ThreadStats> SolveStream();
+    void ReadStream(int fd);
+    static void* ThreadSolveStream(void* arg);
+
+    // Streaming mode: records expression index's result and prints every
+    // result no longer waiting on an earlier one
+    void EmitResult(std::size_t index, bool is_sat);
+
+    // Searches one slice of one expression's assignments; true if satisfied
+    bool SolveSlice(size_t idx, size_t slice);
+
+    // False when SatSolver decides the expression without brute force
+    bool NeedsSearch(const CompiledExpression& program) const;
     
     friend struct ThreadData;
     
     std::size_t n_threads_;
     std::string filename_;
     std::size_t n_vars_;
-    std::vector<std::string> expressions_;
+    std::size_t chunk_size_;
+    bool enumerate_;
+    bool stream_;
+    // The input is a table written by bool-expr-convert, mapped into table_
+    // and solved in place, rather than text
+    bool binary_;
+    ExpressionTable table_;
+    // Streaming mode only; bounds how far reading runs ahead of solving
+    static const std::size_t kQueueCapacity = 1024;
+    std::unique_ptr<BoundedQueue<StreamItem>> queue_;
+    // Streaming mode only: results not yet printed, in a ring indexed by
+    // expression, and the next expression to print. Reading waits while
+    // kReorderWindow expressions are unprinted, so the ring never wraps
+    // onto a result still waiting. Guarded by mutex_.
+    static const std::size_t kReorderWindow = 4 * kQueueCapacity;
+    enum Result : char { kPending, kSat, kUnsat };
+    std::vector<Result> reorder_;
+    std::size_t next_print_;
+    pthread_cond_t printed_ = PTHREAD_COND_INITIALIZER;
+    // The input file stays mapped for the solver's lifetime and expressions
+    // are views of its lines, so loading copies no expression text
+    char* mapping_;
+    std::size_t mapping_size_;
+    std::vector<std::string_view> expressions_;
+    // expressions_[i] compiled, done while loading
+    std::vector<CompiledExpression> programs_;
+    std::size_t n_expressions_;
+    // Work item k is slice k % slices_ of expression k / slices_. There is
+    // one slice per expression unless expressions are brute forced
+    // (--enumerate) and there are fewer of them than threads, in which case
+    // each expression's 2^n assignments are split so every thread has
+    // something to search.
+    std::size_t slices_;
+    std::unique_ptr<ExpressionSearch[]> searches_;  // only when slices_ > 1
+    // Index of the next unclaimed work item; threads pull work from here
+    // instead of being handed a fixed partition up front
+    std::atomic<std::size_t> next_item_;
     pthread_mutex_t mutex_ = PTHREAD_MUTEX_INITIALIZER;
 };
 
@@ -1,12 +1,16 @@
 #include <n_sat_solver.h>
 #include <bool_expr_parser.h>
+#include <bool_expr_compiler.h>
 #include <iostream>
 #include <iomanip>
 #include <string>
 #include <vector>
+#include <cerrno>
 #include <cstring>
 #include <fstream>
 #include <algorithm>
+#include <iterator>
+#include <cctype>
 #include <pthread.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -22,11 +26,33 @@ void debug_print(const std::string& msg) {
 }
 
 NSatSolver::NSatSolver(std::size_t n_threads, const std::string& filename, 
-                       std::size_t n_vars)
-    : n_threads_(n_threads), filename_(filename), n_vars_(n_vars) {
+                       std::size_t n_vars, const SolverOptions& options)
+    : n_threads_(n_threads), filename_(filename), n_vars_(n_vars),
+      chunk_size_(options.chunk_size ? options.chunk_size : 1),
+      enumerate_(options.enumerate), stream_(options.stream),
+      binary_(filename != "-" && ExpressionTable::IsBinary(filename)),
+      next_print_(0), mapping_(nullptr), mapping_size_(0), n_expressions_(0), slices_(1),
+      next_item_(0) {
     // ENTERING CRITICAL SECTION EXITING CRITICAL SECTION
     // No synchronization needed in constructor as this executes before threads are created
-    LoadExpressions();
+
+    // A binary table is already compact and needs no reading, so it is
+    // always mapped whole, even when streaming was asked for
+    if (binary_) {
+        stream_ = false;
+        if (table_.Load(filename_))
+            n_expressions_ = table_.Size();
+        else
+            std::cerr << "Error: " << table_.Error() << std::endl;
+    } else if (!stream_) {
+        LoadExpressions();
+    }
+}
+
+NSatSolver::~NSatSolver() {
+    // UNMAPPING FILE
+    if (mapping_)
+        munmap(mapping_, mapping_size_);
 }
 
 void NSatSolver::LoadExpressions() {
@@ -46,6 +72,12 @@ void NSatSolver::LoadExpressions() {
         return;
     }
     
+    // An empty file has nothing to map (and mmap rejects a zero length)
+    if (sb.st_size == 0) {
+        close(fd);
+        return;
+    }
+
     // MEMORY MAPPING FILE
     char* addr = static_cast<char*>(mmap(nullptr, sb.st_size, 
                                        PROT_READ, MAP_PRIVATE, fd, 0));
@@ -54,52 +86,110 @@ void NSatSolver::LoadExpressions() {
         std::cerr << "Error: Could not map file" << std::endl;
         return;
     }
+
+    // CLOSING FILE (the mapping remains valid without the descriptor)
+    close(fd);
+
+    mapping_ = addr;
+    mapping_size_ = sb.st_size;
+
+    // The file is scanned front to back once, so ask for aggressive
+    // read-ahead and for the kernel to start paging it in now
+    madvise(addr, sb.st_size, MADV_SEQUENTIAL);
+    madvise(addr, sb.st_size, MADV_WILLNEED);
     
     // READING FILE
-    const char* current = addr;
-    const char* end = addr + sb.st_size;
-    size_t line_count = 0;
+    // Below kMinLoadBytes per thread, thread startup outweighs the scan
+    const size_t kMinLoadBytes = 1 << 16;
+    size_t n_parts = std::max<size_t>(1, std::min(n_threads_, mapping_size_ / kMinLoadBytes));
+    std::vector<LoadTask> tasks = SplitLines(addr, addr + sb.st_size, n_parts);
+
+    std::vector<pthread_t> threads(tasks.size());
+    std::vector<bool> started(tasks.size(), false);
+    for (size_t i = 1; i < tasks.size(); ++i) {
+        // CREATING PTHREADS
+        started[i] = pthread_create(&threads[i], nullptr, &NSatSolver::ThreadLoad,
+                                    &tasks[i]) == 0;
+    }
+
+    // This thread takes the first range, and any whose thread failed to start
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        if (!started[i]) ThreadLoad(&tasks[i]);
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        if (started[i]) {
+            // JOINING PTHREADS
+            pthread_join(threads[i], nullptr);
+        }
+        total += tasks[i].lines.size();
+    }
+
+    // Concatenate the ranges in file order
+    expressions_.reserve(total);
+    programs_.reserve(total);
+    for (LoadTask& task : tasks) {
+        expressions_.insert(expressions_.end(), task.lines.begin(), task.lines.end());
+        std::move(task.programs.begin(), task.programs.end(),
+                  std::back_inserter(programs_));
+    }
+    
+    n_expressions_ = programs_.size();
+    debug_print("Loaded " + std::to_string(n_expressions_) + " expressions using " +
+                std::to_string(tasks.size()) + " threads");
+}
+
+std::vector<LoadTask> NSatSolver::SplitLines(const char* begin, const char* end,
+                                             size_t n_parts) {
+    // Each cut is moved forward to just past a newline, so a line belongs
+    // to the range holding its first byte
+    std::vector<LoadTask> tasks;
+    const char* start = begin;
+    for (size_t i = 1; i <= n_parts; ++i) {
+        const char* cut = end;
+        if (i < n_parts) {
+            cut = begin + (end - begin) * i / n_parts;
+            if (cut < start) cut = start;
+            const char* newline = static_cast<const char*>(memchr(cut, '\n', end - cut));
+            cut = newline ? newline + 1 : end;
+        }
+        if (cut > start) tasks.push_back({start, cut, {}, {}});
+        start = cut;
+    }
+    return tasks;
+}
+
+// START ROUTINE
+void* NSatSolver::ThreadLoad(void* arg) {
+    LoadTask* task = static_cast<LoadTask*>(arg);
+    const char* current = task->begin;
+    const char* end = task->end;
     
     while (current < end) {
         const char* newline = static_cast<const char*>(memchr(current, '\n', end - current));
-        size_t length = newline ? newline - current : end - current;
-        
-        if (length > 0) {
-            std::string line(current, length);
-            if (!line.empty() && line.back() == '\r') {
-                line.pop_back();  // Handle Windows-style line endings
-            }
-            
-            // Skip empty lines and comments
-            if (!line.empty() && line[0] != '/' && line[0] != '#') {
-                // Trim whitespace
-                line.erase(0, line.find_first_not_of(" \t\r\n"));
-                line.erase(line.find_last_not_of(" \t\r\n") + 1);
-                
-                debug_print("Raw line " + std::to_string(line_count) + ": " + line);
-                
-                // Process with Explode
-                std::string processed_line = Explode(line.c_str());
-                
-                debug_print("Processed line " + std::to_string(line_count) + ": " + processed_line);
-                
-                if (!processed_line.empty()) {
-                    expressions_.push_back(processed_line);
-                    line_count++;
-                }
-            }
+        const char* line_end = newline ? newline : end;
+
+        // Trim whitespace, including '\r' from Windows-style line endings;
+        // blanks inside the expression are skipped by the compiler
+        const char* first = current;
+        while (first < line_end && std::isspace(static_cast<unsigned char>(*first)))
+            ++first;
+        const char* last = line_end;
+        while (last > first && std::isspace(static_cast<unsigned char>(last[-1])))
+            --last;
+
+        // Skip empty lines and comments
+        if (first < last && *first != '/' && *first != '#') {
+            std::string_view line(first, last - first);
+            task->lines.push_back(line);
+            task->programs.emplace_back(line);
         }
         
         current = newline ? newline + 1 : end;
     }
-    
-    // UNMAPPING FILE
-    munmap(addr, sb.st_size);
-    
-    // CLOSING FILE
-    close(fd);
-    
-    debug_print("Loaded " + std::to_string(expressions_.size()) + " expressions");
+
+    return nullptr;
 }
 
 // START ROUTINE
@@ -109,30 +199,57 @@ void* NSatSolver::ThreadSolve(void* arg) {
     
     data->stats = {0, 0};
     
-    // Only keep the expression_indices code path, since that's what we're using
-    for (size_t idx : data->expression_indices) {
-        if (idx >= solver->expressions_.size()) continue;
+    // Claim chunks of work items until none are left, so a thread that drew
+    // expensive expressions simply claims fewer chunks than the others
+    const size_t n_items = solver->n_expressions_ * solver->slices_;
+    for (;;) {
+        size_t begin = solver->next_item_.fetch_add(
+            solver->chunk_size_, std::memory_order_relaxed);
+        if (begin >= n_items) break;
+        size_t end = std::min(begin + solver->chunk_size_, n_items);
+
+        debug_print("Thread " + std::to_string(data->thread_id) + " claimed " +
+                    std::to_string(begin) + "-" + std::to_string(end - 1));
+
+        for (size_t item = begin; item < end; ++item) {
+            size_t idx = item / solver->slices_;
+            size_t slice = item % solver->slices_;
         
-        const std::string& expr = solver->expressions_[idx];
+            debug_print("\n=== Thread " + std::to_string(data->thread_id) + " ===");
+            debug_print("Evaluating expression " + std::to_string(idx) + ", slice " +
+                        std::to_string(slice) +
+                        (solver->binary_ ? "" : ": " + std::string(solver->expressions_[idx])));
+            debug_print("Using " + std::to_string(solver->n_vars_) + " variables");
         
-        debug_print("\n=== Thread " + std::to_string(data->thread_id) + " ===");
-        debug_print("Evaluating expression " + std::to_string(idx) + ": " + expr);
-        debug_print("Using " + std::to_string(solver->n_vars_) + " variables");
+            bool is_sat;
+            if (solver->slices_ == 1) {
+                is_sat = solver->SolveSlice(idx, 0);
+            } else {
+                // Skip the slice outright if another thread already satisfied it
+                ExpressionSearch& search = solver->searches_[idx];
+                if (!search.found.load(std::memory_order_relaxed)
+                    && solver->SolveSlice(idx, slice)) {
+                    search.found.store(true, std::memory_order_relaxed);
+                }
+
+                // Whoever finishes the expression's last slice counts its result
+                if (search.slices_left.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                    continue;
+                is_sat = search.found.load(std::memory_order_relaxed);
+            }
         
-        // Use the SatSolver function to evaluate the expression
-        bool is_sat = SatSolver(solver->n_vars_, expr);
+            debug_print("Result for expression " + std::to_string(idx) + ": " + 
+                      (is_sat ? "SAT" : "UNSAT"));
         
-        debug_print("Result for expression " + std::to_string(idx) + ": " + 
-                  (is_sat ? "SAT" : "UNSAT"));
+            if (is_sat) {
+                data->stats.sat_count++;
+            } else {
+                data->stats.unsat_count++;
+            }
         
-        if (is_sat) {
-            data->stats.sat_count++;
-        } else {
-            data->stats.unsat_count++;
+            debug_print("Running counts - SAT: " + std::to_string(data->stats.sat_count) +
+                      " UNSAT: " + std::to_string(data->stats.unsat_count));
         }
-        
-        debug_print("Running counts - SAT: " + std::to_string(data->stats.sat_count) +
-                  " UNSAT: " + std::to_string(data->stats.unsat_count));
     }
     
     // Create result with thread ID stored
@@ -143,63 +260,125 @@ void* NSatSolver::ThreadSolve(void* arg) {
     return result;
 }
 
+bool NSatSolver::NeedsSearch(const CompiledExpression& program) const {
+    bool searchable = !program.HasError()
+                   && (n_vars_ >= 26 || !(program.Variables() >> n_vars_));
+    return searchable && (!program.IsDnf() || enumerate_);
+}
+
+bool NSatSolver::SolveSlice(size_t idx, size_t slice) {
+    // A binary table is decided straight from its mapped terms; a program is
+    // only rebuilt from them (no text involved) when brute force was asked for
+    if (binary_ && !enumerate_)
+        return slice == 0 && SatSolver(n_vars_, table_, idx);
+
+    CompiledExpression rebuilt;
+    if (binary_)
+        rebuilt = CompiledExpression(table_.TermsBegin(idx), table_.TermsEnd(idx));
+    const CompiledExpression& program = binary_ ? rebuilt : programs_[idx];
+
+    // Errors and DNF expressions are decided outright (see SatSolver), so
+    // only the first slice has anything to do
+    if (!NeedsSearch(program))
+        return slice == 0 && SatSolver(n_vars_, program);
+
+    // Otherwise brute force this slice's share of the assignments, giving up
+    // as soon as any slice of the expression finds a satisfying one
+    if (slices_ == 1)
+        return program.SearchAssignments(n_vars_);
+    uint64_t blocks = CompiledExpression::SearchBlocks(n_vars_);
+    uint64_t first = blocks * slice / slices_;
+    uint64_t last = blocks * (slice + 1) / slices_;
+    return program.SearchAssignments(n_vars_, first, last, &searches_[idx].found);
+}
+
 void NSatSolver::Solve() {
-    if (expressions_.empty()) return;
+    if (!stream_ && n_expressions_ == 0) return;
 
-    std::cout << "Thread  Sat  Unsat" << std::endl;
-    
-    // Use a consistent round-robin distribution for all file sizes
-    std::vector<std::vector<size_t>> thread_expressions(n_threads_);
-    
-    // Distribute expressions in a round-robin fashion
-    for (size_t i = 0; i < expressions_.size(); ++i) {
-        size_t thread_id = i % n_threads_;
-        thread_expressions[thread_id].push_back(i);
+    // Streaming prints each expression's result as it goes, ahead of the
+    // table
+    std::vector<ThreadStats> stats;
+    if (stream_) {
+        stats = SolveStream();
+    } else {
+        // With fewer expressions than threads, split each expression's search
+        // so the spare threads are not left idle. Only brute force is worth
+        // splitting: every expression the grammar accepts is in DNF, which
+        // SatSolver decides from its terms unless --enumerate was given.
+        slices_ = enumerate_ && n_expressions_ < n_threads_ ? n_threads_ : 1;
+        if (slices_ > 1) {
+            searches_.reset(new ExpressionSearch[n_expressions_]);
+            for (size_t i = 0; i < n_expressions_; ++i) {
+                searches_[i].found = false;
+                searches_[i].slices_left = slices_;
+            }
+        }
+
+        // Threads pull work items from next_item_ as they go, so there is
+        // nothing to partition; just skip threads that could never claim work
+        next_item_ = 0;
+        size_t n_items = n_expressions_ * slices_;
+        size_t n_chunks = (n_items + chunk_size_ - 1) / chunk_size_;
+        size_t n_workers = std::min(n_threads_, n_chunks);
+
+        std::vector<pthread_t> threads;
+        std::vector<ThreadData*> thread_data;
+        StartWorkers(n_workers, &NSatSolver::ThreadSolve, &threads, &thread_data);
+        stats = JoinWorkers(threads, thread_data);
     }
-    
-    std::vector<pthread_t> threads(n_threads_);
-    std::vector<ThreadData*> thread_data;
-    
-    // Create thread data with assigned expressions
-    for (size_t i = 0; i < n_threads_; ++i) {
-        if (thread_expressions[i].empty()) continue;
-        
-        // Create with simplified ThreadData structure
+
+    // Sort results by thread ID
+    std::sort(stats.begin(), stats.end(), 
+        [](const ThreadStats& a, const ThreadStats& b) { 
+            return a.thread_id < b.thread_id; 
+        });
+
+    // Print results in order
+    // ENTERING CRITICAL SECTION
+    {
+        ThreadMutexGuard guard(mutex_);
+        std::cout << "Thread  Sat  Unsat" << std::endl;
+        for (const auto& stat : stats) {
+            std::cout << std::setw(6) << stat.thread_id
+                    << std::setw(5) << stat.sat_count
+                    << std::setw(7) << stat.unsat_count
+                    << std::endl;
+        }
+    }
+    // EXITING CRITICAL SECTION
+
+    PrintResults(stats);
+}
+
+void NSatSolver::StartWorkers(size_t n_workers, void* (*routine)(void*),
+                              std::vector<pthread_t>* threads,
+                              std::vector<ThreadData*>* thread_data) {
+    threads->resize(n_workers);
+    for (size_t i = 0; i < n_workers; ++i) {
         ThreadData* data = new ThreadData{
             i,                // thread_id
             this,             // solver
-            {0, 0},           // stats
-            {}                // expression_indices (empty vector)
+            {0, 0}            // stats
         };
-        data->expression_indices = thread_expressions[i];
-        thread_data.push_back(data);
-        
-        debug_print("Thread " + std::to_string(i) + " assigned " + 
-                   std::to_string(thread_expressions[i].size()) + " expressions: ");
-        
-        // Debug print to show which expressions are assigned to each thread
-        if (DEBUG) {
-            std::string exprs;
-            for (size_t idx : thread_expressions[i]) {
-                exprs += std::to_string(idx) + " ";
-            }
-            debug_print("  Expressions: " + exprs);
-        }
+        thread_data->push_back(data);
     }
     
     // Create all threads (let them run in parallel)
-    for (size_t i = 0; i < thread_data.size(); ++i) {
-        ThreadData* data = thread_data[i];
+    for (size_t i = 0; i < thread_data->size(); ++i) {
+        ThreadData* data = (*thread_data)[i];
         
         // CREATING PTHREADS
-        int result = pthread_create(&threads[i], nullptr, &NSatSolver::ThreadSolve, data);
+        int result = pthread_create(&(*threads)[i], nullptr, routine, data);
         if (result != 0) {
             std::cerr << "Failed to create thread " << i << std::endl;
             delete data;
-            thread_data[i] = nullptr;
+            (*thread_data)[i] = nullptr;
         }
     }
-    
+}
+
+std::vector<ThreadStats> NSatSolver::JoinWorkers(std::vector<pthread_t>& threads,
+                                                 std::vector<ThreadData*>& thread_data) {
     // Now join all threads and collect results
     std::vector<ThreadStats> stats;
     for (size_t i = 0; i < threads.size() && i < thread_data.size(); ++i) {
@@ -213,27 +392,147 @@ void NSatSolver::Solve() {
             delete static_cast<ThreadStats*>(thread_result);
         }
     }
+    return stats;
+}
 
-    // Sort results by thread ID
-    std::sort(stats.begin(), stats.end(), 
-        [](const ThreadStats& a, const ThreadStats& b) { 
-            return a.thread_id < b.thread_id; 
-        });
+std::vector<ThreadStats> NSatSolver::SolveStream() {
+    // OPENING FILE
+    int fd = filename_ == "-" ? STDIN_FILENO : open(filename_.c_str(), O_RDONLY);
+    if (fd == -1) {
+        std::cerr << "Error: Could not open file " << filename_ << std::endl;
+        return {};
+    }
 
-    // Print results in order
-    // ENTERING CRITICAL SECTION
-    {
-        ThreadMutexGuard guard(mutex_);
-        for (const auto& stat : stats) {
-            std::cout << std::setw(6) << stat.thread_id
-                    << std::setw(5) << stat.sat_count
-                    << std::setw(7) << stat.unsat_count
-                    << std::endl;
+    queue_.reset(new BoundedQueue<StreamItem>(kQueueCapacity));
+    reorder_.assign(kReorderWindow, kPending);
+    next_print_ = 0;
+
+    std::vector<pthread_t> threads;
+    std::vector<ThreadData*> thread_data;
+    StartWorkers(std::max<size_t>(n_threads_, 1), &NSatSolver::ThreadSolveStream,
+                 &threads, &thread_data);
+
+    // Workers start solving as soon as the first line is queued
+    ReadStream(fd);
+    queue_->Close();
+
+    // CLOSING FILE
+    if (fd != STDIN_FILENO)
+        close(fd);
+
+    return JoinWorkers(threads, thread_data);
+}
+
+void NSatSolver::ReadStream(int fd) {
+    // Holds at most one partial line between reads
+    std::vector<char> buffer(1 << 20);
+    size_t filled = 0;
+    size_t line_count = 0;
+
+    for (;;) {
+        if (filled == buffer.size())
+            buffer.resize(buffer.size() * 2);  // a single very long line
+
+        // READING FILE
+        ssize_t bytes_read = read(fd, buffer.data() + filled, buffer.size() - filled);
+        if (bytes_read < 0 && errno == EINTR) continue;
+        if (bytes_read < 0)
+            std::cerr << "Error: Could not read " << filename_ << std::endl;
+        bool at_end = bytes_read <= 0;
+        if (!at_end) filled += bytes_read;
+
+        // Queue every complete line, or everything once input has ended
+        const char* current = buffer.data();
+        const char* end = buffer.data() + filled;
+        while (current < end) {
+            const char* newline = static_cast<const char*>(memchr(current, '\n', end - current));
+            if (!newline && !at_end) break;
+            const char* line_end = newline ? newline : end;
+
+            const char* first = current;
+            while (first < line_end && std::isspace(static_cast<unsigned char>(*first)))
+                ++first;
+            const char* last = line_end;
+            while (last > first && std::isspace(static_cast<unsigned char>(last[-1])))
+                --last;
+
+            // Skip empty lines and comments
+            if (first < last && *first != '/' && *first != '#') {
+                // ENTERING CRITICAL SECTION
+                {
+                    // Wait for room in the reorder window
+                    ThreadMutexGuard guard(mutex_);
+                    while (line_count - next_print_ >= kReorderWindow)
+                        pthread_cond_wait(&printed_, &mutex_);
+                }
+                // EXITING CRITICAL SECTION
+                queue_->Push({line_count, CompiledExpression(std::string_view(first, last - first))});
+                line_count++;
+            }
+
+            current = newline ? newline + 1 : end;
         }
+
+        if (at_end) break;
+
+        // Keep the partial line for the next read
+        filled = end - current;
+        std::memmove(buffer.data(), current, filled);
     }
-    // EXITING CRITICAL SECTION
 
-    PrintResults(stats);
+    debug_print("Streamed " + std::to_string(line_count) + " expressions");
+}
+
+// START ROUTINE
+void* NSatSolver::ThreadSolveStream(void* arg) {
+    ThreadData* data = static_cast<ThreadData*>(arg);
+    NSatSolver* solver = data->solver;
+    
+    data->stats = {0, 0};
+
+    // Expressions are solved whole here, in the order they are popped
+    StreamItem item;
+    while (solver->queue_->Pop(&item)) {
+        const CompiledExpression& program = item.program;
+        bool is_sat = solver->NeedsSearch(program)
+                    ? program.SearchAssignments(solver->n_vars_)
+                    : SatSolver(solver->n_vars_, program);
+
+        if (is_sat) {
+            data->stats.sat_count++;
+        } else {
+            data->stats.unsat_count++;
+        }
+        solver->EmitResult(item.index, is_sat);
+    }
+
+    ThreadStats* result = new ThreadStats(data->stats);
+    result->thread_id = data->thread_id;
+    
+    delete data;
+    return result;
+}
+
+void NSatSolver::EmitResult(size_t index, bool is_sat) {
+    // ENTERING CRITICAL SECTION
+    ThreadMutexGuard guard(mutex_);
+    reorder_[index % kReorderWindow] = is_sat ? kSat : kUnsat;
+
+    // Print this result and any later ones that were only waiting on it
+    size_t first = next_print_;
+    while (reorder_[next_print_ % kReorderWindow] != kPending) {
+        Result& result = reorder_[next_print_ % kReorderWindow];
+        std::cout << "Expression " << next_print_ << ": "
+                  << (result == kSat ? "SAT" : "UNSAT") << '\n';
+        result = kPending;
+        ++next_print_;
+    }
+
+    if (next_print_ != first) {
+        std::cout.flush();
+        pthread_cond_signal(&printed_);
+    }
+    // EXITING CRITICAL SECTION
 }
 
 void NSatSolver::PrintResults(const std::vector<ThreadStats>& stats) {
@@ -257,9 +556,11 @@ void NSatSolver::PrintResults(const std::vector<ThreadStats>& stats) {
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 4) {
+    if (argc < 4 || argc > 7) {
         std::cerr << "Usage: " << argv[0] 
-                  << " <number of threads> <input file> <number of variables>" 
+                  << " <number of threads> <input file | -> <number of variables>" 
+                  << " [chunk size] [--enumerate] [--stream]" << std::endl;
+        std::cerr << "--stream prints each expression's result, in order, as it is solved"
                   << std::endl;
         return 1;
     }
@@ -268,8 +569,21 @@ int main(int argc, char* argv[]) {
         std::size_t n_threads = std::stoul(argv[1]);
         std::string filename = argv[2];
         std::size_t n_vars = std::stoul(argv[3]);
+        SolverOptions options;
+        for (int i = 4; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--enumerate")
+                options.enumerate = true;
+            else if (arg == "--stream")
+                options.stream = true;
+            else
+                options.chunk_size = std::stoul(arg);
+        }
+        // Standard input can only be read as a stream
+        if (filename == "-")
+            options.stream = true;
 
-        NSatSolver solver(n_threads, filename, n_vars);
+        NSatSolver solver(n_threads, filename, n_vars, options);
         solver.Solve();
 
     } catch (const std::exception& e) {
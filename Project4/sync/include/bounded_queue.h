@@ -0,0 +1,189 @@
+// Copyright 2025 CSCE 311
+//
+// A fixed-capacity, lock-free, multi-producer/multi-consumer FIFO queue
+// (Dmitry Vyukov's bounded MPMC design). Each cell carries a sequence number
+// telling producers and consumers whether it is free or full for their
+// current lap around the ring, so neither side ever takes a lock.
+//
+// The blocking Push/Pop wrappers retry for a bounded number of yields while
+// the queue is full or empty, then sleep on a condition variable until the
+// other side makes progress. The fast paths take no lock: a side only locks
+// to wake the other when it has announced that it is sleeping. Once a
+// producer calls Close(), Pop drains what is left and then returns false.
+//
+#ifndef SYNC_INCLUDE_BOUNDED_QUEUE_H_
+#define SYNC_INCLUDE_BOUNDED_QUEUE_H_
+
+#include <sched.h>  // sched_yield
+
+#include <atomic>              // std::atomic
+#include <condition_variable>  // std::condition_variable
+#include <cstddef>             // std::size_t
+#include <memory>              // std::unique_ptr
+#include <mutex>               // std::mutex
+#include <utility>             // std::move
+
+template <typename T>
+class BoundedQueue {
+ public:
+  // capacity is rounded up to a power of two
+  explicit BoundedQueue(std::size_t capacity)
+      : enqueue_pos_(0), dequeue_pos_(0), closed_(false),
+        waiting_producers_(0), waiting_consumers_(0) {
+    std::size_t size = 2;
+    while (size < capacity)
+      size <<= 1;
+
+    cells_.reset(new Cell[size]);
+    mask_ = size - 1;
+    for (std::size_t i = 0; i < size; ++i)
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  // Returns false without blocking if the queue is full
+  bool TryPush(T&& value) {
+    std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[pos & mask_];
+      std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      std::ptrdiff_t lap = static_cast<std::ptrdiff_t>(sequence - pos);
+
+      if (lap == 0) {  // free this lap; try to claim it
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          cell.value = std::move(value);
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (lap < 0) {  // still full from the previous lap
+        return false;
+      } else {  // another producer got here first
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Returns false without blocking if the queue is empty
+  bool TryPop(T* value) {
+    std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[pos & mask_];
+      std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      std::ptrdiff_t lap = static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+
+      if (lap == 0) {  // full this lap; try to claim it
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          *value = std::move(cell.value);
+          cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (lap < 0) {  // not yet written
+        return false;
+      } else {  // another consumer got here first
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Waits for room
+  void Push(T&& value) {
+    auto ready = [&] { return TryPush(std::move(value)); };
+    for (std::size_t spin = 0; !ready(); ++spin) {
+      if (spin < kSpins) {
+        sched_yield();
+      } else {
+        Sleep(&waiting_producers_, &not_full_, ready);
+        break;
+      }
+    }
+    Wake(waiting_consumers_, &not_empty_);
+  }
+
+  // Waits for a value; false once the queue is closed and empty
+  bool Pop(T* value) {
+    bool popped = false;
+    auto ready = [&] {
+      popped = TryPop(value);
+      return popped || closed_.load(std::memory_order_acquire);
+    };
+    for (std::size_t spin = 0; !ready(); ++spin) {
+      if (spin < kSpins) {
+        sched_yield();
+      } else {
+        Sleep(&waiting_consumers_, &not_empty_, ready);
+        break;
+      }
+    }
+
+    // Everything pushed before Close() is visible once closed_ is seen
+    if (!popped)
+      popped = TryPop(value);
+    if (popped)
+      Wake(waiting_producers_, &not_full_);
+    return popped;
+  }
+
+  // Called by the producer after its last Push; wakes every sleeping
+  // consumer to drain the queue and return
+  void Close() {
+    closed_.store(true, std::memory_order_seq_cst);
+    std::lock_guard<std::mutex> lock(mutex_);
+    not_empty_.notify_all();
+  }
+
+ private:
+  struct Cell {
+    std::atomic<std::size_t> sequence;
+    T value;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  std::size_t mask_;
+  // Producers and consumers each get their own cache line
+  alignas(64) std::atomic<std::size_t> enqueue_pos_;
+  alignas(64) std::atomic<std::size_t> dequeue_pos_;
+  std::atomic<bool> closed_;
+
+  // Yields a blocked Push or Pop makes before it sleeps
+  static const std::size_t kSpins = 64;
+
+  // Announces a wait in *waiting, then sleeps on condition until ready()
+  // holds. ready() is checked under mutex_ after the announcement, so a
+  // Wake that missed the announcement has already made ready() true.
+  template <typename Ready>
+  void Sleep(std::atomic<std::size_t>* waiting,
+             std::condition_variable* condition,
+             Ready ready) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    waiting->fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    condition->wait(lock, ready);
+    waiting->fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  // Wakes a thread sleeping on condition, if waiting says there is one.
+  // Taking mutex_ first means the sleeper is either still before its last
+  // check of ready() or already waiting.
+  void Wake(const std::atomic<std::size_t>& waiting,
+            std::condition_variable* condition) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting.load(std::memory_order_relaxed) == 0)
+      return;
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    condition->notify_one();
+  }
+
+  // Only touched by threads that have run out of spins
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::atomic<std::size_t> waiting_producers_;
+  std::atomic<std::size_t> waiting_consumers_;
+
+  // Non-copyable, non-movable
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+};
+
+#endif  // SYNC_INCLUDE_BOUNDED_QUEUE_H_
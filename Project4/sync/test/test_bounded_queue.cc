@@ -0,0 +1,122 @@
+// Copyright 2025 CSCE 311
+//
+// Exercises BoundedQueue from one thread, then from several producers and
+// consumers at once through a queue small enough that both sides block and
+// sleep, and finally checks that Close() wakes consumers sleeping on an
+// empty queue.
+
+#include <bounded_queue.h>
+#include <test_check.h>
+
+#include <unistd.h>  // usleep
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void TestSingleThread() {
+  BoundedQueue<int> queue(3);  // rounded up to 4
+
+  bool pushed = true;
+  for (int i = 0; i < 4; ++i)
+    pushed = pushed && queue.TryPush(int(i));
+  Check(pushed, "a queue holds its rounded-up capacity");
+  Check(!queue.TryPush(4), "TryPush fails on a full queue");
+
+  bool in_order = true;
+  int value = -1;
+  for (int i = 0; i < 4; ++i)
+    in_order = in_order && queue.TryPop(&value) && value == i;
+  Check(in_order, "values come out in the order they went in");
+  Check(!queue.TryPop(&value), "TryPop fails on an empty queue");
+
+  queue.Push(7);
+  queue.Close();
+  Check(queue.Pop(&value) && value == 7, "Pop drains a closed queue");
+  Check(!queue.Pop(&value), "Pop returns false once closed and empty");
+}
+
+void TestProducersAndConsumers() {
+  const std::size_t kProducers = 3;
+  const std::size_t kConsumers = 3;
+  const std::size_t kPerProducer = 20000;
+  BoundedQueue<std::size_t> queue(4);
+
+  std::vector<std::vector<std::size_t>> seen(kConsumers);
+  std::vector<std::thread> consumers;
+  for (std::size_t c = 0; c < kConsumers; ++c) {
+    consumers.emplace_back([&, c] {
+      std::size_t value;
+      while (queue.Pop(&value))
+        seen[c].push_back(value);
+    });
+  }
+
+  std::vector<std::thread> producers;
+  for (std::size_t p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&, p] {
+      for (std::size_t i = 0; i < kPerProducer; ++i)
+        queue.Push(p * kPerProducer + i);
+    });
+  }
+  for (std::thread& producer : producers)
+    producer.join();
+  queue.Close();
+  for (std::thread& consumer : consumers)
+    consumer.join();
+
+  // Every value arrives exactly once, and each consumer sees any one
+  // producer's values in the order they were pushed
+  std::vector<char> counted(kProducers * kPerProducer, 0);
+  bool once = true, ordered = true;
+  for (const std::vector<std::size_t>& values : seen) {
+    std::vector<std::size_t> last(kProducers, 0);
+    std::vector<bool> any(kProducers, false);
+    for (std::size_t value : values) {
+      once = once && value < counted.size() && !counted[value]++;
+      std::size_t p = value / kPerProducer;
+      ordered = ordered && (!any[p] || last[p] < value);
+      any[p] = true;
+      last[p] = value;
+    }
+  }
+  for (char count : counted)
+    once = once && count == 1;
+  Check(once, "every pushed value is popped exactly once");
+  Check(ordered, "one producer's values stay in order");
+}
+
+void TestCloseWakesSleepers() {
+  BoundedQueue<int> queue(4);
+  std::atomic<std::size_t> returned(0);
+
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < 4; ++c) {
+    consumers.emplace_back([&] {
+      int value;
+      while (queue.Pop(&value)) {}
+      ++returned;
+    });
+  }
+
+  // Long enough for the consumers to run out of spins and sleep
+  ::usleep(100000);
+  Check(returned == 0, "consumers wait on an empty open queue");
+  queue.Close();
+  for (std::thread& consumer : consumers)
+    consumer.join();
+  Check(returned == 4, "Close() wakes every sleeping consumer");
+}
+
+}  // namespace
+
+int main() {
+  TestSingleThread();
+  TestProducersAndConsumers();
+  TestCloseWakesSleepers();
+
+  return failures == 0 ? 0 : 1;
+}
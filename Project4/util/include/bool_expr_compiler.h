@@ -0,0 +1,151 @@
+// Copyright CSCE 311 Spring 2025
+//
+// Compiles a Boolean expression once into a flat postfix program so that it
+// may be evaluated many times without re-tokenizing the source text. The
+// accepted grammar is the same as BooleanExpressionParser's:
+//
+//   Expression -> Term { "+" Term }
+//   Term -> Factor { "*" Factor }
+//   Factor -> Variable ["'"]
+//   Variable -> [a-z]
+//
+// Unlike the parser, blanks between tokens are skipped, so expressions may be
+// compiled straight from file text. For example, "a*b' + c" compiles to
+//
+//   LOAD a, LOAD_NOT b, AND, LOAD c, OR
+//
+// Because the grammar has no parentheses every expression it accepts is in
+// disjunctive normal form, so the compiler also records each product term as
+// a pair of bitmasks; satisfiability then takes one pass over the terms.
+//
+
+#ifndef UTIL_INCLUDE_BOOL_EXPR_COMPILER_H_
+#define UTIL_INCLUDE_BOOL_EXPR_COMPILER_H_
+
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <bool_expr_parser.h>
+
+
+class CompiledExpression {
+ public:
+  // Postfix instruction set. LOAD and LOAD_NOT push a variable (or its
+  // complement) onto the value stack, AND and OR pop two values and push one.
+  enum class OpCode : std::uint8_t { kLoad, kLoadNot, kAnd, kOr };
+
+  struct Instruction {
+    OpCode op;
+    std::uint8_t variable;  // 0 for 'a', 1 for 'b', ..., unused by AND/OR
+  };
+
+  // A product term: bit i of positive (negative) is set when variable
+  // char('a' + i) appears uncomplemented (complemented) in the term
+  struct Term {
+    std::uint32_t positive;
+    std::uint32_t negative;
+  };
+
+  // Deepest value stack any program is allowed to need
+  static const std::size_t kMaxStackDepth = 64;
+
+  CompiledExpression()
+      : variables_(0), is_dnf_(false), has_error_(true), err_msg_("") {
+    // empty
+  }
+
+  // Compiles the expression; check HasError() before evaluating. The text is
+  // not referenced once the constructor returns.
+  explicit CompiledExpression(std::string_view expression);
+
+  // Rebuilds the program for a sum of the given product terms, e.g., ones
+  // read back from a saved ExpressionTable. No text is involved.
+  CompiledExpression(const Term* begin, const Term* end);
+
+  // Evaluates the program with the given variable values. Sets *error (when
+  // provided) if the expression did not compile or references a variable
+  // missing from values; the result is false in that case.
+  bool Evaluate(const std::unordered_map<char, bool>& values,
+                bool* error = nullptr) const;
+
+  // As above, for the dense assignment type; no lookups or allocation
+  bool Evaluate(const TruthAssignment& assignment,
+                bool* error = nullptr) const;
+
+  // Bit-sliced evaluation: bit k of variables[i] holds the value of variable
+  // char('a' + i) in the k-th of 64 independent assignments, and bit k of the
+  // result is the expression's value under that assignment. Only variables
+  // set in Variables() are read. The program must have compiled.
+  std::uint64_t Evaluate(const std::uint64_t variables[26]) const;
+
+  // Determines whether some assignment to the variables a, b, ...,
+  // char('a' + (n - 1)) satisfies the expression. A DNF expression is
+  // satisfiable iff one of its terms holds no variable both complemented and
+  // uncomplemented, which is checked in O(terms); anything else falls back to
+  // SearchAssignments. Returns false if the program did not compile or uses
+  // a variable outside the first n.
+  bool Satisfiable(std::size_t n_variables) const;
+
+  // Brute-force search of all 2^n assignments, a block of 64 or more
+  // assignments per instruction
+  bool SearchAssignments(std::size_t n_variables) const;
+
+  // Searches only blocks [first, last) of the SearchBlocks(n) blocks that
+  // make up the 2^n assignments, so several threads can split one search.
+  // Returns false early, without finishing, once *stop becomes true.
+  bool SearchAssignments(std::size_t n_variables,
+                         std::uint64_t first,
+                         std::uint64_t last,
+                         const std::atomic<bool>* stop = nullptr) const;
+
+  // Number of blocks the assignments of n variables are searched in
+  static std::uint64_t SearchBlocks(std::size_t n_variables);
+
+  bool HasError() const {
+    return has_error_;
+  }
+
+  const std::string Error() const {
+    return err_msg_;
+  }
+
+  // Bit i is set when variable char('a' + i) appears in the expression
+  std::uint32_t Variables() const {
+    return variables_;
+  }
+
+  const std::vector<Instruction>& Program() const {
+    return program_;
+  }
+
+  // True when Terms() describes the whole expression
+  bool IsDnf() const {
+    return is_dnf_;
+  }
+
+  const std::vector<Term>& Terms() const {
+    return terms_;
+  }
+
+ private:
+  // Runs the program where bit i of values holds variable char('a' + i)
+  bool Run(std::uint32_t values) const;
+
+  std::vector<Instruction> program_;
+  std::vector<Term> terms_;
+  std::uint32_t variables_;
+  bool is_dnf_;
+  bool has_error_;
+  std::string err_msg_;
+
+  friend class BooleanExpressionCompiler;
+};
+
+
+#endif  // UTIL_INCLUDE_BOOL_EXPR_COMPILER_H_
@@ -18,6 +18,7 @@
 
 
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <unordered_map>
@@ -32,8 +33,10 @@ const std::string Explode(const char input[], char delim = ' ');
 
 
 //
-// Attempts 2^n evaluations to determine if there exists a variable assignment
-// that satisfies (makes true) the boolean expression in the given string.
+// Determines if there exists a variable assignment that satisfies (makes
+// true) the boolean expression in the given string. Expressions are in DNF,
+// so this checks each product term for a contradiction (x and x') rather
+// than attempting all 2^n evaluations.
 //
 // Variable names are assumed to be 'a', 'b', ..., up to char('a' + (n - 1)).
 //
@@ -42,6 +45,14 @@ const std::string Explode(const char input[], char delim = ' ');
 bool SatSolver(std::size_t n, const std::string& expression);
 
 
+//
+// As above, for an expression already compiled (see bool_expr_compiler.h),
+// so callers that keep the program around need not tokenize it again.
+//
+class CompiledExpression;
+bool SatSolver(std::size_t n, const CompiledExpression& program);
+
+
 //
 // Constructs a map from the characters a, b, c, ... x, y, z, one for each
 // Boolean value supplied.
@@ -49,6 +60,26 @@ bool SatSolver(std::size_t n, const std::string& expression);
 const std::unordered_map<char, bool> BuildMap(const std::string& boolean_values);
 
 
+//
+// A dense alternative to the map above, for hot loops: bit i of values holds
+// the value of variable char('a' + i), and bit i of defined is set when that
+// variable has a value at all. Lookups are a shift and a mask with no heap
+// allocation.
+//
+struct TruthAssignment {
+  std::uint32_t values;
+  std::uint32_t defined;
+};
+
+
+//
+// Constructs a TruthAssignment for a, b, c, ... from the Boolean values
+// supplied ('T' is true, anything else false), like BuildMap. Values past
+// the 26th are ignored.
+//
+const TruthAssignment BuildAssignment(const std::string& boolean_values);
+
+
 //
 // A Boolean expression parser, capable of parsing variables, a-z, ORs +,
 // ANDs *, and complemented variables, e.g., a' or z'.
@@ -57,21 +88,31 @@ typedef std::unordered_map<char, bool> ValueMap;
 class BooleanExpressionParser {
  public:
   explicit BooleanExpressionParser(const std::string& expr)
-      : expression_(expr), values_(nullptr), current_index_(0),
-        has_error_(0), err_msg_("") {
+      : expression_(expr), values_(nullptr), assignment_(nullptr),
+        current_index_(0), has_error_(0), err_msg_("") {
     // empty
   }
 
 
   BooleanExpressionParser(const std::string& expression,
                           const ValueMap& values)
-    : expression_(expression), values_(&values), current_index_(0),
-      has_error_(0), err_msg_("") {
+    : expression_(expression), values_(&values), assignment_(nullptr),
+      current_index_(0), has_error_(0), err_msg_("") {
+    // empty
+  }
+
+
+  BooleanExpressionParser(const std::string& expression,
+                          const TruthAssignment& assignment)
+    : expression_(expression), values_(nullptr), assignment_(&assignment),
+      current_index_(0), has_error_(0), err_msg_("") {
     // empty
   }
 
   bool Parse(const std::unordered_map<char, bool>& values);
 
+  bool Parse(const TruthAssignment& assignment);
+
   bool Parse();
 
   bool HasError() const;
@@ -98,11 +139,15 @@ class BooleanExpressionParser {
   // Parse primary values: variables (a-z), optionally negated with `'`
   bool ParseFactor();
 
+  // Looks up a variable in whichever of values_ or assignment_ is set
+  bool Lookup(char variable, bool* value) const;
+
   void ReportError(const std::string& message);
 
 
   std::string expression_;
   const std::unordered_map<char, bool>* values_;
+  const TruthAssignment* assignment_;
   size_t current_index_;
   bool has_error_;
   std::string err_msg_;
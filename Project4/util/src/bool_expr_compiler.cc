@@ -0,0 +1,438 @@
+// Copyright CSCE 311 Spring 2025
+//
+
+#include <bool_expr_compiler.h>
+
+#include <algorithm>
+#include <cctype>
+
+
+namespace {
+
+// Bit k of kLanePattern[i] is bit i of k, so within a block of 64 consecutive
+// assignments variables a-f take every combination of values
+const std::uint64_t kLanePattern[6] = {
+  0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+  0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull
+};
+
+#if defined(__GNUC__)
+// The vectors in SearchWide never cross a call boundary (see RunSliced), so
+// the ABI notes GCC emits for them do not apply
+#pragma GCC diagnostic ignored "-Wpsabi"
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE inline
+#endif
+
+// Shared stack machine for scalar and vector words. Always inlined so each
+// SearchWide clone below gets a copy built for its own instruction set.
+template <typename Word>
+ALWAYS_INLINE Word RunSliced(const CompiledExpression::Instruction* program,
+               std::size_t length,
+               const Word* variables) {
+  Word stack[CompiledExpression::kMaxStackDepth];
+  std::size_t top = 0;
+
+  for (std::size_t i = 0; i < length; ++i) {
+    switch (program[i].op) {
+      case CompiledExpression::OpCode::kLoad:
+        stack[top++] = variables[program[i].variable];
+        break;
+      case CompiledExpression::OpCode::kLoadNot:
+        stack[top++] = ~variables[program[i].variable];
+        break;
+      case CompiledExpression::OpCode::kAnd:
+        --top;
+        stack[top - 1] &= stack[top];
+        break;
+      case CompiledExpression::OpCode::kOr:
+        --top;
+        stack[top - 1] |= stack[top];
+        break;
+    }
+  }
+
+  return stack[0];
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+// Eight 64-bit blocks, i.e., 512 assignments per instruction. GCC lowers the
+// operators to AVX-512, AVX2, or plain 64-bit code according to the clone the
+// loader picks for the running CPU.
+typedef std::uint64_t WideWord __attribute__((vector_size(64)));
+const std::size_t kWideBlocks = sizeof(WideWord) / sizeof(std::uint64_t);
+
+// Searches groups [first, last) of kWideBlocks blocks; variable 6 + j of
+// block b within group g is bit j of (g * kWideBlocks + b). Gives up once
+// *stop (if given) is set.
+__attribute__((target_clones("avx512f", "avx2", "default")))
+bool SearchWide(const CompiledExpression::Instruction* program,
+                std::size_t length,
+                std::size_t n_variables,
+                std::uint64_t first,
+                std::uint64_t last,
+                const std::atomic<bool>* stop) {
+  WideWord variables[26];
+  for (std::size_t i = 0; i < 6; ++i)
+    for (std::size_t b = 0; b < kWideBlocks; ++b)
+      variables[i][b] = kLanePattern[i];
+  // Variables 6..8 select the block inside a group
+  for (std::size_t i = 6; i < 9; ++i)
+    for (std::size_t b = 0; b < kWideBlocks; ++b)
+      variables[i][b] = (b >> (i - 6) & 1) ? ~0ull : 0;
+
+  for (std::uint64_t group = first; group < last; ++group) {
+    if (stop && stop->load(std::memory_order_relaxed))
+      return false;
+
+    for (std::size_t i = 9; i < n_variables; ++i) {
+      std::uint64_t word = (group >> (i - 9) & 1) ? ~0ull : 0;
+      for (std::size_t b = 0; b < kWideBlocks; ++b)
+        variables[i][b] = word;
+    }
+
+    WideWord result = RunSliced(program, length, variables);
+    std::uint64_t any = 0;
+    for (std::size_t b = 0; b < kWideBlocks; ++b)
+      any |= result[b];
+    if (any)
+      return true;
+  }
+
+  return false;
+}
+#endif
+
+}  // namespace
+
+
+//
+// Recursive descent over the same grammar as BooleanExpressionParser, but
+// emitting instructions instead of computing values.
+//
+class BooleanExpressionCompiler {
+ public:
+  BooleanExpressionCompiler(std::string_view expression,
+                            CompiledExpression* output)
+      : expression_(expression), output_(output), current_index_(0),
+        depth_(0) {
+    // empty
+  }
+
+  void Compile() {
+    SkipBlanks();
+    CompileExpr();
+    if (!output_->has_error_ && current_index_ != expression_.size()) {
+      std::string parsed(expression_.substr(0, current_index_));
+      std::string unexpected(expression_.substr(current_index_));
+      ReportError("Unexpected tokens after parsing: \"" + parsed + "<->"
+                  + unexpected + "\"");
+    }
+    if (output_->has_error_) {
+      output_->program_.clear();
+      output_->terms_.clear();
+    } else {
+      output_->is_dnf_ = true;
+    }
+  }
+
+ private:
+  char CurrentChar() const {
+    if (current_index_ < expression_.size())
+      return expression_[current_index_];
+    return '\0';
+  }
+
+  // Advance past the current character and any blanks following it
+  void Consume() {
+    if (current_index_ < expression_.size())
+      ++current_index_;
+    SkipBlanks();
+  }
+
+  void SkipBlanks() {
+    while (current_index_ < expression_.size()
+           && (expression_[current_index_] == ' '
+               || expression_[current_index_] == '\t'
+               || expression_[current_index_] == '\r'))
+      ++current_index_;
+  }
+
+  // Parse OR ('+') expressions
+  void CompileExpr() {
+    CompileTerm();
+    while (!output_->has_error_ && CurrentChar() == '+') {
+      Consume();
+      CompileTerm();
+      Emit(CompiledExpression::OpCode::kOr, 0);
+    }
+  }
+
+  // Parse AND ('*') expressions
+  void CompileTerm() {
+    output_->terms_.push_back({0, 0});
+    CompileFactor();
+    while (!output_->has_error_ && CurrentChar() == '*') {
+      Consume();
+      CompileFactor();
+      Emit(CompiledExpression::OpCode::kAnd, 0);
+    }
+  }
+
+  // Parse primary values: variables (a-z), optionally negated with `'`
+  void CompileFactor() {
+    char token = CurrentChar();
+
+    if (std::isalpha(token)) {
+      Consume();  // consume the variable
+      bool negated = false;
+
+      if (CurrentChar() == '\'') {
+        Consume();  // consume the negation
+        negated = true;
+      }
+
+      // BuildMap only ever defines a-z, so anything else can never evaluate
+      if (token < 'a' || token > 'z') {
+        ReportError("Undefined variable: " + std::string(1, token));
+        return;
+      }
+
+      std::uint8_t variable = static_cast<std::uint8_t>(token - 'a');
+      std::uint32_t bit = std::uint32_t(1) << variable;
+      output_->variables_ |= bit;
+      CompiledExpression::Term& term = output_->terms_.back();
+      (negated ? term.negative : term.positive) |= bit;
+      Emit(negated ? CompiledExpression::OpCode::kLoadNot
+                   : CompiledExpression::OpCode::kLoad,
+           variable);
+      return;
+    }
+
+    ReportError("Unexpected token: \"" + std::string(1, token)
+                                       + "\", expr: \""
+                                       + std::string(expression_) + "\"");
+  }
+
+  void Emit(CompiledExpression::OpCode op, std::uint8_t variable) {
+    if (output_->has_error_)
+      return;
+
+    if (op == CompiledExpression::OpCode::kAnd
+        || op == CompiledExpression::OpCode::kOr) {
+      --depth_;
+    } else if (++depth_ > CompiledExpression::kMaxStackDepth) {
+      ReportError("Expression too deeply nested");
+      return;
+    }
+    output_->program_.push_back({op, variable});
+  }
+
+  void ReportError(const std::string& message) {
+    if (!output_->has_error_) {
+      output_->err_msg_ = "Error: " + message;
+      output_->has_error_ = true;
+    }
+  }
+
+  std::string_view expression_;
+  CompiledExpression* output_;
+  std::size_t current_index_;
+  std::size_t depth_;
+};
+
+
+CompiledExpression::CompiledExpression(std::string_view expression)
+    : variables_(0), is_dnf_(false), has_error_(false), err_msg_("") {
+  BooleanExpressionCompiler compiler(expression, this);
+  compiler.Compile();
+}
+
+
+CompiledExpression::CompiledExpression(const Term* begin, const Term* end)
+    : terms_(begin, end), variables_(0), is_dnf_(true), has_error_(false),
+      err_msg_("") {
+  for (const Term& term : terms_) {
+    std::uint32_t literals = term.positive | term.negative;
+    if (!literals || literals >> 26) {
+      program_.clear();
+      terms_.clear();
+      is_dnf_ = false;
+      has_error_ = true;
+      err_msg_ = "Error: Invalid product term";
+      return;
+    }
+    variables_ |= literals;
+
+    // LOAD each literal, AND it with the ones before, then OR the term in
+    bool first = true;
+    for (std::uint8_t i = 0; i < 26; ++i) {
+      std::uint32_t bit = std::uint32_t(1) << i;
+      if (term.positive & bit) {
+        program_.push_back({OpCode::kLoad, i});
+        if (!first) program_.push_back({OpCode::kAnd, 0});
+        first = false;
+      }
+      if (term.negative & bit) {
+        program_.push_back({OpCode::kLoadNot, i});
+        if (!first) program_.push_back({OpCode::kAnd, 0});
+        first = false;
+      }
+    }
+    if (&term != &terms_.front())
+      program_.push_back({OpCode::kOr, 0});
+  }
+
+  if (terms_.empty()) {
+    is_dnf_ = false;
+    has_error_ = true;
+    err_msg_ = "Error: Empty expression";
+  }
+}
+
+
+bool CompiledExpression::Evaluate(const std::unordered_map<char, bool>& values,
+                                  bool* error) const {
+  if (has_error_) {
+    if (error) *error = true;
+    return false;
+  }
+
+  // Resolve each referenced variable once, rather than once per occurrence
+  std::uint32_t bits = 0;
+  for (std::uint8_t i = 0; i < 26; ++i) {
+    if (!(variables_ >> i & 1))
+      continue;
+
+    auto it = values.find(static_cast<char>('a' + i));
+    if (it == values.end()) {
+      if (error) *error = true;
+      return false;
+    }
+    if (it->second)
+      bits |= std::uint32_t(1) << i;
+  }
+
+  if (error) *error = false;
+  return Run(bits);
+}
+
+
+bool CompiledExpression::Evaluate(const TruthAssignment& assignment,
+                                  bool* error) const {
+  if (has_error_ || (variables_ & ~assignment.defined)) {
+    if (error) *error = true;
+    return false;
+  }
+
+  if (error) *error = false;
+  return Run(assignment.values);
+}
+
+
+bool CompiledExpression::Run(std::uint32_t values) const {
+  bool stack[kMaxStackDepth];
+  std::size_t top = 0;
+
+  for (const Instruction& instruction : program_) {
+    switch (instruction.op) {
+      case OpCode::kLoad:
+        stack[top++] = values >> instruction.variable & 1;
+        break;
+      case OpCode::kLoadNot:
+        stack[top++] = !(values >> instruction.variable & 1);
+        break;
+      case OpCode::kAnd:
+        --top;
+        stack[top - 1] = stack[top - 1] && stack[top];
+        break;
+      case OpCode::kOr:
+        --top;
+        stack[top - 1] = stack[top - 1] || stack[top];
+        break;
+    }
+  }
+
+  return top == 1 && stack[0];
+}
+
+
+std::uint64_t CompiledExpression::Evaluate(
+    const std::uint64_t variables[26]) const {
+  return RunSliced(program_.data(), program_.size(), variables);
+}
+
+
+bool CompiledExpression::Satisfiable(std::size_t n_variables) const {
+  if (has_error_)
+    return false;
+
+  if (n_variables < 26 && variables_ >> n_variables)
+    return false;
+
+  if (!is_dnf_)
+    return SearchAssignments(n_variables);
+
+  for (const Term& term : terms_)
+    if (!(term.positive & term.negative))
+      return true;
+
+  return false;
+}
+
+
+bool CompiledExpression::SearchAssignments(std::size_t n_variables) const {
+  return SearchAssignments(n_variables, 0, SearchBlocks(n_variables));
+}
+
+
+std::uint64_t CompiledExpression::SearchBlocks(std::size_t n_variables) {
+  n_variables = std::min<std::size_t>(n_variables, 26);
+#if defined(__GNUC__) && defined(__x86_64__)
+  if (n_variables >= 9)
+    return std::uint64_t(1) << (n_variables - 9);
+#endif
+  return n_variables > 6 ? std::uint64_t(1) << (n_variables - 6) : 1;
+}
+
+
+bool CompiledExpression::SearchAssignments(
+    std::size_t n_variables,
+    std::uint64_t first,
+    std::uint64_t last,
+    const std::atomic<bool>* stop) const {
+  if (has_error_)
+    return false;
+
+  // Only a-z exist, so further variables cannot change the outcome
+  n_variables = std::min<std::size_t>(n_variables, 26);
+  if (variables_ >> n_variables)
+    return false;
+
+  last = std::min(last, SearchBlocks(n_variables));
+
+#if defined(__GNUC__) && defined(__x86_64__)
+  if (n_variables >= 9)
+    return SearchWide(program_.data(), program_.size(), n_variables,
+                      first, last, stop);
+#endif
+
+  std::uint64_t variables[26];
+  std::copy(kLanePattern, kLanePattern + 6, variables);
+
+  // With fewer than 6 variables the lanes past 2^n repeat earlier
+  // assignments, so the whole word may still be tested
+  for (std::uint64_t block = first; block < last; ++block) {
+    if (stop && stop->load(std::memory_order_relaxed))
+      return false;
+
+    for (std::size_t i = 6; i < n_variables; ++i)
+      variables[i] = (block >> (i - 6) & 1) ? ~0ull : 0;
+
+    if (Evaluate(variables))
+      return true;
+  }
+
+  return false;
+}
@@ -1,24 +1,33 @@
 #include <bool_expr_parser.h>
+#include <bool_expr_compiler.h>
+
+#include <algorithm>
 
 bool SatSolver(std::size_t total_variables, const std::string& expression) {
-  BooleanExpressionParser parser(expression);
-  for (int i = 0; i < 1 << total_variables; ++i) {
-    ValueMap values;
-
-    // For each bit position (variable), assign value
-    for (std::size_t j = 0; j < total_variables; ++j) {
-      char var = 'a' + static_cast<char>(j);
-      bool val = (i >> j) & 1;  // e.g. 1 0 1&1 -> 1 0&1 1 -> 1&1 0 1 -> etc
-      values[var] = val;
-    }
+  // Tokenize once, recording the product terms as bitmasks
+  return SatSolver(total_variables, CompiledExpression(expression));
+}
 
-    if (parser.Parse(values)) {
-      return true;
-    } else if (parser.HasError()) {
-      std::cerr << "[SATSOLVER] " << parser.Error() << std::endl;
+bool SatSolver(std::size_t total_variables, const CompiledExpression& program) {
+  if (program.HasError()) {
+    std::cerr << "[SATSOLVER] " << program.Error() << std::endl;
+    return false;
+  }
+
+  // Only the first total_variables names have values, as with BuildMap
+  std::uint32_t undefined = total_variables < 26
+                          ? program.Variables() >> total_variables : 0;
+  if (undefined) {
+    char var = 'a' + static_cast<char>(total_variables);
+    while (!(undefined & 1)) {
+      undefined >>= 1;
+      ++var;
     }
+    std::cerr << "[SATSOLVER] Error: Undefined variable: " << var << std::endl;
+    return false;
   }
-  return false;
+
+  return program.Satisfiable(total_variables);
 }
 
 bool BooleanExpressionParser::Parse() {
@@ -34,6 +43,17 @@ bool BooleanExpressionParser::Parse() {
 
 bool BooleanExpressionParser::Parse(const ValueMap& values) {
   values_  = &values;
+  assignment_ = nullptr;
+  // reset parser vars in case this is not first parse of expr
+  current_index_ = 0;
+  has_error_ = 0;
+  err_msg_ = "";
+  return Parse();
+}
+
+bool BooleanExpressionParser::Parse(const TruthAssignment& assignment) {
+  values_ = nullptr;
+  assignment_ = &assignment;
   // reset parser vars in case this is not first parse of expr
   current_index_ = 0;
   has_error_ = 0;
@@ -94,12 +114,12 @@ bool BooleanExpressionParser::ParseFactor() {
       negated = true;
     }
 
-    if (values_->find(token) == values_->end()) {
+    bool value;
+    if (!Lookup(token, &value)) {
       ReportError("Undefined variable: " + std::string(1, token));
       return false;
     }
 
-    bool value = values_->at(token);
     return negated ? !value : value;
   }
 
@@ -110,6 +130,28 @@ bool BooleanExpressionParser::ParseFactor() {
 }
 
 
+bool BooleanExpressionParser::Lookup(char variable, bool* value) const {
+  if (assignment_) {
+    if (variable < 'a' || variable > 'z')
+      return false;
+
+    std::uint32_t bit = std::uint32_t(1) << (variable - 'a');
+    *value = assignment_->values & bit;
+    return assignment_->defined & bit;
+  }
+
+  if (!values_)
+    return false;
+
+  auto it = values_->find(variable);  // a single hash lookup
+  if (it == values_->end())
+    return false;
+
+  *value = it->second;
+  return true;
+}
+
+
 void BooleanExpressionParser::ReportError(const std::string& message) {
   if (!has_error_) {
     err_msg_ = "Error: " + message;
@@ -144,3 +186,16 @@ const std::unordered_map<char, bool> BuildMap(const std::string& b_vals) {
   }
   return values;
 }
+
+
+const TruthAssignment BuildAssignment(const std::string& b_vals) {
+  TruthAssignment assignment = {0, 0};
+  std::size_t n_vals = std::min<std::size_t>(b_vals.size(), 26);
+  for (std::size_t i = 0; i < n_vals; ++i) {
+    std::uint32_t bit = std::uint32_t(1) << i;
+    assignment.defined |= bit;
+    if (b_vals[i] == 'T')
+      assignment.values |= bit;
+  }
+  return assignment;
+}
@@ -0,0 +1,401 @@
+// Copyright CSCE 311 Spring 2025
+//
+
+#include <bool_expr_table.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+
+namespace {
+
+const char kMagic[4] = {'B', 'X', 'P', 'R'};
+
+// Bits of a term that name variables a-z
+const std::uint32_t kVariableMask = (std::uint32_t(1) << 26) - 1;
+
+// Source of ExpressionTable::Generation values, unique across all tables
+std::atomic<std::uint64_t> next_generation(1);
+
+struct FileHeader {
+  char magic[4];
+  std::uint32_t version;
+  std::uint32_t n_expressions;
+  std::uint32_t n_terms;
+};
+
+// Bytes from the start of the file to the term array
+std::size_t TermsOffset(std::size_t n_expressions) {
+  std::size_t offset = sizeof(FileHeader)
+                     + (n_expressions + 1) * sizeof(std::uint32_t);
+  return (offset + 7) & ~std::size_t(7);
+}
+
+// True if the header describes a table of this version that fits in size
+// bytes
+bool HeaderValid(const FileHeader& header, std::size_t size) {
+  std::size_t terms_offset = TermsOffset(header.n_expressions);
+  return std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0
+         && header.version == ExpressionTable::kVersion
+         && terms_offset <= size
+         && (size - terms_offset) / sizeof(ExpressionTable::Term)
+            >= header.n_terms;
+}
+
+// True if first_term gives every expression a run of the header's terms
+bool OffsetsValid(const FileHeader& header, const std::uint32_t* first_term) {
+  bool valid = first_term[0] == 0
+               && first_term[header.n_expressions] == header.n_terms;
+  for (std::size_t i = 0; valid && i < header.n_expressions; ++i)
+    valid = first_term[i] <= first_term[i + 1];
+  return valid;
+}
+
+// True if the descriptor's seals keep it from shrinking or changing, as a
+// memfd its owner sealed, so a mapping of it cannot fault or go stale
+bool Sealed(int fd) {
+  int seals = ::fcntl(fd, F_GET_SEALS);
+  return seals >= 0
+         && (seals & (F_SEAL_SHRINK | F_SEAL_WRITE))
+            == (F_SEAL_SHRINK | F_SEAL_WRITE);
+}
+
+// Reads size bytes at offset, or returns false
+bool ReadAt(int fd, void* buffer, std::size_t size, std::size_t offset) {
+  char* bytes = static_cast<char*>(buffer);
+  while (size > 0) {
+    ::ssize_t bytes_read = ::pread(fd, bytes, size, offset);
+    if (bytes_read <= 0)
+      return false;
+    bytes += bytes_read;
+    size -= bytes_read;
+    offset += bytes_read;
+  }
+  return true;
+}
+
+}  // namespace
+
+
+const ExpressionTable::Term ExpressionTable::kErrorTerm = {~0u, ~0u};
+
+
+ExpressionTable::ExpressionTable()
+    : owned_first_term_(1, 0), mapping_(nullptr), mapping_size_(0),
+      n_expressions_(0), err_msg_("") {
+  Refresh();
+}
+
+
+ExpressionTable::~ExpressionTable() {
+  Clear();
+}
+
+
+void ExpressionTable::Clear() {
+  if (mapping_)
+    munmap(mapping_, mapping_size_);
+  mapping_ = nullptr;
+  mapping_size_ = 0;
+
+  owned_first_term_.assign(1, 0);
+  owned_terms_.clear();
+  n_expressions_ = 0;
+  Refresh();
+}
+
+
+void ExpressionTable::Refresh() {
+  first_term_ = owned_first_term_.data();
+  terms_ = owned_terms_.data();
+  generation_ = next_generation++;
+}
+
+
+bool ExpressionTable::Append(const CompiledExpression& expression) {
+  if (mapping_)
+    return false;
+
+  if (expression.HasError()) {
+    owned_terms_.push_back(kErrorTerm);
+  } else if (expression.IsDnf()) {
+    owned_terms_.insert(owned_terms_.end(), expression.Terms().begin(),
+                        expression.Terms().end());
+  } else {
+    return false;
+  }
+
+  owned_first_term_.push_back(owned_terms_.size());
+  ++n_expressions_;
+  Refresh();
+  return true;
+}
+
+
+bool ExpressionTable::IsBinary(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  char magic[sizeof(kMagic)];
+  return file.read(magic, sizeof(magic))
+         && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+
+bool ExpressionTable::Load(const std::string& path) {
+  Clear();
+
+  // OPENING FILE
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    err_msg_ = "Could not open " + path + ": " + ::strerror(errno);
+    return false;
+  }
+
+  bool loaded = Load(fd, path, true);
+  ::close(fd);  // the mapping outlives the descriptor
+  return loaded;
+}
+
+
+bool ExpressionTable::Load(int fd, const std::string& path) {
+  return Load(fd, path, Sealed(fd));
+}
+
+
+bool ExpressionTable::Load(int fd, const std::string& path, bool map) {
+  Clear();
+
+  struct stat sb;
+  if (::fstat(fd, &sb) < 0
+      || static_cast<std::size_t>(sb.st_size) < sizeof(FileHeader)) {
+    err_msg_ = "Not an expression table: " + path;
+    return false;
+  }
+  if (!map)
+    return Read(fd, sb.st_size, path);
+
+  // MEMORY MAPPING FILE
+  void* addr = ::mmap(nullptr, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (addr == MAP_FAILED) {
+    err_msg_ = "Could not map " + path + ": " + ::strerror(errno);
+    return false;
+  }
+
+  const char* bytes = static_cast<const char*>(addr);
+  FileHeader header;
+  std::memcpy(&header, bytes, sizeof(header));
+
+  std::size_t size = sb.st_size;
+  const std::uint32_t* first_term = reinterpret_cast<const std::uint32_t*>(
+      bytes + sizeof(FileHeader));
+  if (!HeaderValid(header, size) || !OffsetsValid(header, first_term)) {
+    ::munmap(addr, sb.st_size);
+    err_msg_ = "Corrupt or unsupported expression table: " + path;
+    return false;
+  }
+
+  mapping_ = addr;
+  mapping_size_ = size;
+  n_expressions_ = header.n_expressions;
+  first_term_ = first_term;
+  terms_ = reinterpret_cast<const Term*>(
+      bytes + TermsOffset(header.n_expressions));
+  generation_ = next_generation++;
+  return true;
+}
+
+
+bool ExpressionTable::Read(int fd, std::size_t size, const std::string& path) {
+  // The owner may still change the file, so the copy is checked, not the
+  // file; a read cut short by a shrinking file rejects it
+  FileHeader header;
+  bool valid = ReadAt(fd, &header, sizeof(header), 0)
+               && HeaderValid(header, size);
+  if (valid) {
+    owned_first_term_.resize(header.n_expressions + 1);
+    owned_terms_.resize(header.n_terms);
+    valid = ReadAt(fd, owned_first_term_.data(),
+                   owned_first_term_.size() * sizeof(std::uint32_t),
+                   sizeof(FileHeader))
+            && ReadAt(fd, owned_terms_.data(),
+                      owned_terms_.size() * sizeof(Term),
+                      TermsOffset(header.n_expressions))
+            && OffsetsValid(header, owned_first_term_.data());
+  }
+
+  if (!valid) {
+    Clear();
+    err_msg_ = "Corrupt or unsupported expression table: " + path;
+    return false;
+  }
+
+  n_expressions_ = header.n_expressions;
+  Refresh();
+  return true;
+}
+
+
+bool ExpressionTable::Save(const std::string& path) const {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    err_msg_ = "Could not create " + path;
+    return false;
+  }
+
+  FileHeader header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.n_expressions = n_expressions_;
+  header.n_terms = TermCount();
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  file.write(reinterpret_cast<const char*>(first_term_),
+             (n_expressions_ + 1) * sizeof(std::uint32_t));
+
+  const char padding[8] = {0};
+  std::size_t written = sizeof(header)
+                      + (n_expressions_ + 1) * sizeof(std::uint32_t);
+  file.write(padding, TermsOffset(n_expressions_) - written);
+
+  file.write(reinterpret_cast<const char*>(terms_),
+             TermCount() * sizeof(Term));
+
+  if (!file) {
+    err_msg_ = "Could not write " + path;
+    return false;
+  }
+  return true;
+}
+
+
+bool ExpressionTable::HasError(std::size_t i) const {
+  const Term* term = TermsBegin(i);
+  return TermsEnd(i) - term == 1
+         && term->positive == kErrorTerm.positive
+         && term->negative == kErrorTerm.negative;
+}
+
+
+std::uint32_t ExpressionTable::Variables(std::size_t i) const {
+  std::uint32_t variables = 0;
+  for (const Term* term = TermsBegin(i); term != TermsEnd(i); ++term)
+    variables |= term->positive | term->negative;
+  return variables;
+}
+
+
+bool ExpressionTable::Satisfiable(std::size_t i,
+                                  std::size_t n_variables) const {
+  if (HasError(i))
+    return false;
+
+  if (n_variables < 26 && Variables(i) >> n_variables)
+    return false;
+
+  for (const Term* term = TermsBegin(i); term != TermsEnd(i); ++term)
+    if (!(term->positive & term->negative))
+      return true;
+
+  return false;
+}
+
+
+bool ExpressionTable::Evaluate(std::size_t i,
+                               const TruthAssignment& assignment,
+                               bool* error) const {
+  // A term holds when all its positive variables are true and all its
+  // negative ones false. Every term is visited, since any undefined
+  // variable makes the whole expression an error.
+  std::uint32_t used = 0;
+  bool result = false;
+  for (const Term* term = TermsBegin(i); term != TermsEnd(i); ++term) {
+    used |= term->positive | term->negative;
+    result |= !(term->positive & ~assignment.values)
+              && !(term->negative & assignment.values);
+  }
+
+  bool failed = (used & ~assignment.defined) != 0;  // includes kErrorTerm
+  if (error) *error = failed;
+  return result && !failed;
+}
+
+
+std::uint64_t ExpressionTable::Evaluate(std::size_t i,
+                                       const AssignmentBatch& batch,
+                                       std::uint64_t* errors) const {
+  // Each term is the AND of its literals' lanes, so one pass over the terms
+  // settles the expression for all 64 assignments
+  std::uint32_t used = 0;
+  std::uint64_t result = 0;
+  for (const Term* term = TermsBegin(i); term != TermsEnd(i); ++term) {
+    used |= term->positive | term->negative;
+
+    std::uint64_t holds = ~std::uint64_t(0);
+    for (std::uint32_t bits = term->positive & kVariableMask; bits;
+         bits &= bits - 1)
+      holds &= batch.values[__builtin_ctz(bits)];
+    for (std::uint32_t bits = term->negative & kVariableMask; bits;
+         bits &= bits - 1)
+      holds &= ~batch.values[__builtin_ctz(bits)];
+    result |= holds;
+  }
+
+  // An assignment fails if it leaves any variable used undefined; the bits
+  // past z (only kErrorTerm has them) fail every assignment
+  std::uint64_t failed = used & ~kVariableMask ? ~std::uint64_t(0) : 0;
+  for (std::uint32_t bits = used & kVariableMask; bits; bits &= bits - 1)
+    failed |= ~batch.defined[__builtin_ctz(bits)];
+
+  failed &= batch.Lanes();
+  *errors = failed;
+  return result & batch.Lanes() & ~failed;
+}
+
+
+bool AssignmentBatch::Add(const TruthAssignment& assignment) {
+  if (size == kMaxSize)
+    return false;
+
+  std::uint64_t lane = std::uint64_t(1) << size;
+  for (std::size_t j = 0; j < 26; ++j) {
+    if (assignment.values >> j & 1)
+      values[j] |= lane;
+    if (assignment.defined >> j & 1)
+      defined[j] |= lane;
+  }
+  ++size;
+  return true;
+}
+
+
+bool SatSolver(std::size_t total_variables,
+               const ExpressionTable& table,
+               std::size_t i) {
+  if (table.HasError(i)) {
+    std::cerr << "[SATSOLVER] Error: expression " << i
+              << " did not compile" << std::endl;
+    return false;
+  }
+
+  // Only the first total_variables names have values, as with BuildMap
+  std::uint32_t undefined = total_variables < 26
+                          ? table.Variables(i) >> total_variables : 0;
+  if (undefined) {
+    char var = 'a' + static_cast<char>(total_variables);
+    while (!(undefined & 1)) {
+      undefined >>= 1;
+      ++var;
+    }
+    std::cerr << "[SATSOLVER] Error: Undefined variable: " << var << std::endl;
+    return false;
+  }
+
+  return table.Satisfiable(i, total_variables);
+}